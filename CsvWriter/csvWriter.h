@@ -57,13 +57,17 @@ private:
 	template<typename U = T, typename std::enable_if<std::is_same<U, LookupTime>::value>::type* = nullptr>
 	void writeHeader() {
 		output_file << "Benchmark, Mode, Threads, Samples, Score, Score Error (stddev), Unit, Algorithm,"
-			<< "Benchmark, Distribution, Hash Function, Initial Nodes\n";
+			<< "Benchmark, Distribution, Hash Function, Initial Nodes, Capacity, P99, P99.9\n";
 	}
 
 	template<typename U = T, typename std::enable_if<std::is_same<U, ResizeTime>::value || std::is_same<U, InitTime>::value>::type* = nullptr>
 	void writeHeader() {
 		output_file << "Benchmark, Mode, Threads, Samples, Score, Score Error (stddev), Unit, Algorithm,"
-			<< "Hash Function, Initial Nodes\n";
+			<< "Hash Function, Initial Nodes, Capacity";
+		if constexpr (std::is_same<U, ResizeTime>::value) {
+			output_file << ", Max, P99.9";
+		}
+		output_file << '\n';
 	}
 
 	template<typename U = T, typename std::enable_if<std::is_same<U, MemoryUsage>::value>::type* = nullptr>
@@ -175,7 +179,10 @@ public:
 				<< t.param_benchmark << ','
 				<< t.param_distribution << ','
 				<< t.param_function << ','
-				<< t.param_init_nodes << "\n";
+				<< t.param_init_nodes << ','
+				<< t.param_capacity << ','
+				<< t.score_p99 << ','
+				<< t.score_p999 << "\n";
 		}
 		m_cache.clear();
 		output_file.close();
@@ -201,7 +208,12 @@ public:
 				<< t.unit << ','
 				<< t.param_algorithm << ','
 				<< t.param_function << ','
-				<< t.param_init_nodes << "\n";
+				<< t.param_init_nodes << ','
+				<< t.param_capacity;
+			if constexpr (std::is_same<U, ResizeTime>::value) {
+				output_file << ',' << t.score_max << ',' << t.score_p999;
+			}
+			output_file << '\n';
 		}
 		m_cache.clear();
 		output_file.close();
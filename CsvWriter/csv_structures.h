@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cstddef>
+#include <limits>
 
 struct MemoryUsage {
 	std::string type;
@@ -88,6 +89,9 @@ struct LookupTime {
 	std::string param_distribution{};
 	std::string param_function{};
 	std::size_t param_init_nodes{};
+	std::size_t param_capacity{};
+	double score_p99{ std::numeric_limits<double>::quiet_NaN() };
+	double score_p999{ std::numeric_limits<double>::quiet_NaN() };
 
 	explicit LookupTime(const std::string& benchmark, const std::string& mode,
 		std::size_t threads, std::size_t samples, const std::string& unit,
@@ -135,6 +139,9 @@ struct ResizeTime : CommonBase {
 			param_algorithm, param_function, param_init_nodes)
 	{
 	}
+	std::size_t param_capacity{};
+	double score_max{ std::numeric_limits<double>::quiet_NaN() };
+	double score_p999{ std::numeric_limits<double>::quiet_NaN() };
 };
 
 // Just for name clarity
@@ -147,6 +154,7 @@ struct InitTime : CommonBase {
 			param_algorithm, param_function, param_init_nodes)
 	{
 	}
+	std::size_t param_capacity{};
 };
 
 
@@ -21,82 +21,193 @@
 // SOFTWARE.
 #include "AnchorHashQre.hpp"
 #include "./misc/crc32c_sse42_u64.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
 
 using namespace std;
 
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+template <typename T>
+T* AnchorHashQre<Index, Interleaved, FastMod, Lazy>::Allocate(uint32_t n) {
+
+	if constexpr (Lazy) {
+		// Large calloc'ed blocks are zeroed by the kernel on first touch
+		T* p = static_cast<T*>(calloc(n, sizeof(T)));
+		if (!p) throw std::bad_alloc();
+		return p;
+	}
+	else {
+		return new T [n]();
+	}
+
+}
+
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+template <typename T>
+void AnchorHashQre<Index, Interleaved, FastMod, Lazy>::Release(T* p) {
+
+	if constexpr (Lazy) free(p);
+	else delete [] p;
+
+}
+
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+template <typename T>
+T* AnchorHashQre<Index, Interleaved, FastMod, Lazy>::Reallocate(T* p, uint32_t n, uint32_t c) {
+
+	if constexpr (Lazy) {
+		// Large blocks are remapped instead of copied
+		T* q = static_cast<T*>(realloc(p, static_cast<size_t>(c) * sizeof(T)));
+		if (!q) throw std::bad_alloc();
+		return q;
+	}
+	else {
+		T* q = new T [c];
+		std::copy(p, p + n, q);
+		delete [] p;
+		return q;
+	}
+
+}
+
 /** Constructor */
-AnchorHashQre::AnchorHashQre (uint32_t a, uint32_t w) {
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+AnchorHashQre<Index, Interleaved, FastMod, Lazy>::AnchorHashQre (uint32_t a, uint32_t w, bool growable, bool cached)
+	: A_{nullptr}, K_{nullptr}, AK{nullptr}, growable{growable}, S{nullptr}, epoch{1} {
+
+	// A growable anchor starts with the working buckets only
+	if (growable && a < w) a = w;
 	
-	// Allocate the anchor array	
-	A = new uint32_t [a]();
+	// Zeroed shortcuts are of epoch 0, stale
+	if (cached) S = Allocate<Shortcut>(a);
+	
+	// Allocate the anchor and the "map diagonal"
+	if constexpr (Interleaved) {
+		AK = Allocate<Slot>(a);
+	}
+	else {
+		A_ = Allocate<Index>(a);
+		K_ = Allocate<Index>(a);
+	}
 		
 	// Allocate the working array
-	W = new uint32_t [a]();
+	W_ = Allocate<Index>(a);
 
 	// Allocate the last apperance array
-	L = new uint32_t [a]();	
+	L_ = Allocate<Index>(a);
 
-	// Allocate the "map diagonal"	
-	K = new uint32_t [a]();
+	// Set initial set sizes
+	C = a;
+	M = growable ? w : a;
+	N = w;
+	N0 = w;
+
+	// Zero entries already read as their initial values
+	if constexpr (Lazy) {
+		R = w;
+		return;
+	}
+
+	// No initial removals, the slots beyond M are set when they are used
+	if (growable) {
+		for(uint32_t i = 0; i < w; ++i) {
+			L(i) = i;
+			W(i) = i;
+			K(i) = i;
+		}
+		R = w;
+		return;
+	}
 	
 	// Initialize "swap" arrays 
 	for(uint32_t i = 0; i < a; ++i) {
-		L[i] = i;
-		W[i] = i;
-		K[i] = i;
+		L(i) = i;
+		W(i) = i;
+		K(i) = i;
 	}
 				
 	// We treat initial removals as ordered removals
 	for(uint32_t i = a - 1; i >= w; --i) {				
-		A[i] = i;	
+		A(i) = i;	
 		r.push(i);			
 	}
-			
-	// Set initial set sizes
-	M = a;
-	N = w;
+	R = a;
 			
 }
 
 /** Destructor */
-AnchorHashQre::~AnchorHashQre () {
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+AnchorHashQre<Index, Interleaved, FastMod, Lazy>::~AnchorHashQre () {
 	
-	delete [] A;		    
-	delete [] W;	
-	delete [] L;	
-	delete [] K;	
+	Release(A_);
+	Release(K_);
+	Release(AK);
+	Release(W_);
+	Release(L_);
+	Release(S);
 
 }
 
-uint32_t AnchorHashQre::ComputeTranslation(uint32_t i , uint32_t j) {
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+uint32_t AnchorHashQre<Index, Interleaved, FastMod, Lazy>::ComputeTranslation(uint32_t i , uint32_t j) {
 	
-	if (i == j) return K[i];
+	if (i == j) return K(i);
 	
 	uint32_t b = j;
+
+	if (S) {
+		const uint32_t t = A(i);
+		const Shortcut& s = S[j];
+		if (s.epoch == epoch && s.lo < t && t <= s.hi) return s.to;
+
+		// The result holds down to the removal level of the previous bucket
+		uint32_t p = j;
+		while (t <= A(b)) {
+			p = b;
+			b = K(b);
+		}
+		S[j] = {static_cast<Index>(b), static_cast<Index>(A(b)), static_cast<Index>(A(p)), epoch};
+		return b;
+	}
 	
-	while (A[i] <= A[b]) {
-		b = K[b];
+	while (A(i) <= A(b)) {
+		b = K(b);
 	}
 	
 	return b;
 
 }
 
-uint32_t AnchorHashQre::ComputeBucket(uint64_t key1 , uint64_t key2) {
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+void AnchorHashQre<Index, Interleaved, FastMod, Lazy>::Invalidate() {
+
+	if (!S) return;
+
+	// The epochs wrap after 2^32 updates: stale shortcuts could match again
+	if (++epoch == 0) {
+		for (uint32_t i = 0; i < C; ++i) S[i].epoch = 0;
+		epoch = 1;
+	}
+
+}
+
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+uint32_t AnchorHashQre<Index, Interleaved, FastMod, Lazy>::ComputeBucket(uint64_t key1 , uint64_t key2) {
 								
 	// First hash is uniform on the anchor set
 	uint32_t bs = crc32c_sse42_u64(key1, key2);
-	uint32_t b = bs % M;
+	uint32_t b = First(bs);
 						
 	// Loop until hitting a working bucket
-	while (A[b] != 0) {	
+	while (A(b) != 0) {	
 			
 		// New candidate (bs - for better balance - avoid patterns)			
 		bs = crc32c_sse42_u64(key1 - bs, key2 + bs);
-		uint32_t h = bs % A[b];
+		uint32_t h = Reduce(bs, A(b));
 				
 		//  h is working or observed by bucket
-		if ((A[h] == 0) || (A[h] < A[b])) {
+		if ((A(h) == 0) || (A(h) < A(b))) {
 			b = h;
 		}
 						
@@ -111,7 +222,141 @@ uint32_t AnchorHashQre::ComputeBucket(uint64_t key1 , uint64_t key2) {
 										
 }
 
-uint32_t AnchorHashQre::UpdateRemoval(uint32_t b) {
+/*
+ * Batched ComputeBucket: LANES lookups are stepped round-robin as small state
+ * machines. Every step reads the slot of A or K prefetched by the previous
+ * step of the same lane and prefetches the next one, so the cache misses of
+ * different keys overlap instead of being paid one after the other. A lane
+ * takes the next key as soon as its lookup is over. Small anchors, whose
+ * arrays fit in the cache, use the scalar loop. The buckets are the same
+ * as ComputeBucket(keys[i], key2).
+ */
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+void AnchorHashQre<Index, Interleaved, FastMod, Lazy>::ComputeBuckets(const uint64_t* keys, uint64_t key2, uint32_t* buckets, size_t count) {
+
+	static constexpr size_t LANES = 16;
+
+	// Below this capacity A and K stay in the cache: no miss to overlap.
+	static constexpr uint32_t SCALAR_CAPACITY = 1 << 14;
+
+	if (M <= SCALAR_CAPACITY) {
+		for (size_t i = 0; i < count; ++i) {
+			buckets[i] = ComputeBucket(keys[i], key2);
+		}
+		return;
+	}
+
+	enum State : uint8_t {
+		CHECK,		// b is the candidate: is it working?
+		CHOOSE,		// h is the new candidate: working or observed by b?
+		DIAGONAL,	// translation of (b, b): b becomes K[b]
+		TRANSLATE_K,	// translation of (b, h): h becomes K[h]...
+		TRANSLATE_A,	// ...until A[h] < A[b]
+		IDLE
+	};
+
+	struct Lane {
+		uint64_t key;
+		size_t index;
+		uint32_t bs;	// last hash
+		uint32_t b;	// current bucket
+		uint32_t ab;	// A[b]
+		uint32_t h;	// candidate or translation cursor
+		State state;
+	} lanes[LANES];
+
+	size_t next = 0;
+	size_t active = 0;
+
+	auto start = [&](Lane& lane) {
+		if (next == count) {
+			lane.state = IDLE;
+			--active;
+			return;
+		}
+		lane.index = next;
+		lane.key = keys[next++];
+		lane.bs = crc32c_sse42_u64(lane.key, key2);
+		lane.b = First(lane.bs);
+		lane.state = CHECK;
+		__builtin_prefetch(APtr(lane.b));
+	};
+
+	// b is the new candidate and ab = A[b] is already loaded.
+	auto candidate = [&](Lane& lane, uint32_t b, uint32_t ab) {
+		if (ab == 0) {
+			buckets[lane.index] = b;
+			start(lane);
+			return;
+		}
+		lane.b = b;
+		lane.ab = ab;
+		lane.bs = crc32c_sse42_u64(lane.key - lane.bs, key2 + lane.bs);
+		lane.h = Reduce(lane.bs, ab);
+		lane.state = CHOOSE;
+		__builtin_prefetch(APtr(lane.h));
+	};
+
+	for (size_t l = 0; l < LANES; ++l) {
+		++active;
+		start(lanes[l]);
+	}
+
+	while (active) {
+		for (size_t l = 0; l < LANES; ++l) {
+			Lane& lane = lanes[l];
+			switch (lane.state) {
+			case CHECK:
+				candidate(lane, lane.b, A(lane.b));
+				break;
+			case CHOOSE: {
+				const uint32_t ah = A(lane.h);
+				if ((ah == 0) || (ah < lane.ab)) {
+					candidate(lane, lane.h, ah);
+				}
+				else if (lane.h == lane.b) {
+					lane.state = DIAGONAL;
+					__builtin_prefetch(KPtr(lane.b));
+				}
+				else {
+					lane.state = TRANSLATE_K;
+					__builtin_prefetch(KPtr(lane.h));
+				}
+				break;
+			}
+			case DIAGONAL:
+				lane.b = K(lane.b);
+				lane.state = CHECK;
+				__builtin_prefetch(APtr(lane.b));
+				break;
+			case TRANSLATE_K:
+				lane.h = K(lane.h);
+				lane.state = TRANSLATE_A;
+				__builtin_prefetch(APtr(lane.h));
+				break;
+			case TRANSLATE_A: {
+				const uint32_t ah = A(lane.h);
+				if (lane.ab <= ah) {
+					lane.state = TRANSLATE_K;
+					__builtin_prefetch(KPtr(lane.h));
+				}
+				else {
+					candidate(lane, lane.h, ah);
+				}
+				break;
+			}
+			case IDLE:
+				break;
+			}
+		}
+	}
+
+}
+
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+uint32_t AnchorHashQre<Index, Interleaved, FastMod, Lazy>::UpdateRemoval(uint32_t b) {
+
+	Invalidate();
 
 	// update reserved stack
 	r.push(b);
@@ -120,38 +365,94 @@ uint32_t AnchorHashQre::UpdateRemoval(uint32_t b) {
 	N--;
 		
 	// who is the replacement
-	W[L[b]] = W[N];
-	L[W[N]] = L[b];
+	W(L(b)) = W(N);
+	L(W(N)) = L(b);
 		
 	// Update map diagonal
-	K[b] = W[N];
+	K(b) = W(N);
 
 	// Update removal
-	A[b] = N;
+	A(b) = N;
 		
 	return 0;	
 															
 }
 
-uint32_t AnchorHashQre::UpdateNewBucket() {
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+uint32_t AnchorHashQre<Index, Interleaved, FastMod, Lazy>::UpdateNewBucket() {
+
+	Invalidate();
 
 	// Who was removed last?	
-	uint32_t b = r.top();							
-	r.pop();
+	uint32_t b;
+	if (!r.empty()) {
+		b = r.top();
+		r.pop();
+	}
+	else if (growable) {
+		// Append a bucket to the anchor (N == M)
+		if (M == C) Reserve(C < 0x80000000u ? 2 * C : 0xFFFFFFFFu);
+		b = M++;
+		W(b) = b;
+		L(b) = b;
+	}
+	else {
+		b = R++;
+	}
 	
 	// Restore in observed_set
-	L[W[N]] = N;	
-	W[L[b]] = b;
+	L(W(N)) = N;	
+	W(L(b)) = b;
 	
 	// update live set size
 	N++;
 		
 	// Ressurect
-	A[b] = 0;
+	A(b) = 0;
 	
 	// Restore in diagonal
-	K[b] = b;
+	K(b) = b;
 	
 	return b;
 									
 }
+
+template <typename Index, bool Interleaved, bool FastMod, bool Lazy>
+void AnchorHashQre<Index, Interleaved, FastMod, Lazy>::Reserve(uint32_t c) {
+
+	if (!growable || c <= C) return;
+
+	// Only the slots of the anchor are in use
+	if constexpr (Interleaved) {
+		AK = Reallocate(AK, M, c);
+	}
+	else {
+		A_ = Reallocate(A_, M, c);
+		K_ = Reallocate(K_, M, c);
+	}
+	W_ = Reallocate(W_, M, c);
+	L_ = Reallocate(L_, M, c);
+	if (S) {
+		S = Reallocate(S, M, c);
+		std::fill(S + M, S + c, Shortcut{});
+	}
+	C = c;
+
+}
+
+template class AnchorHashQre<uint16_t, false, false, false>;
+template class AnchorHashQre<uint32_t, false, false, false>;
+template class AnchorHashQre<uint16_t, true, false, false>;
+template class AnchorHashQre<uint32_t, true, false, false>;
+template class AnchorHashQre<uint16_t, false, true, false>;
+template class AnchorHashQre<uint32_t, false, true, false>;
+template class AnchorHashQre<uint16_t, true, true, false>;
+template class AnchorHashQre<uint32_t, true, true, false>;
+template class AnchorHashQre<uint16_t, false, false, true>;
+template class AnchorHashQre<uint32_t, false, false, true>;
+template class AnchorHashQre<uint16_t, true, false, true>;
+template class AnchorHashQre<uint32_t, true, false, true>;
+template class AnchorHashQre<uint16_t, false, true, true>;
+template class AnchorHashQre<uint32_t, false, true, true>;
+template class AnchorHashQre<uint16_t, true, true, true>;
+template class AnchorHashQre<uint32_t, true, true, true>;
@@ -22,46 +22,197 @@
 #include <iostream>
 #include <stack>
 #include <stdint.h>
+#include <stddef.h>
+#include "../fliphash/fliphashengine.h"
 
-/** Class declaration */
+/** Class declaration
+ *
+ * Index is the integer type of the entries of the arrays: uint16_t is
+ * enough for anchors of at most 65,536 buckets and halves the memory.
+ * With Interleaved, A[b] and K[b] are stored next to each other in a
+ * single array of slots, so that a lookup step touches one cache
+ * line instead of two; W and L are only used by the updates and stay apart.
+ * With FastMod, a hash is reduced to a range n with the multiply-shift
+ * (hash * n) >> 32 instead of hash % n: the lookups never divide, but the
+ * keys are mapped differently.
+ * With Lazy, the construction takes constant time: the arrays come from
+ * calloc, whose large blocks are mapped on first touch, and every entry is
+ * stored XORed with its initial value, so that a zero reads as initialized.
+ * The initial removals are kept as the implicit range [R, M) instead of
+ * being pushed on the stack. The decoding costs a few operations per step
+ * of a lookup, and calloc'ed memory is not seen by the heap statistics.
+ *
+ * A growable anchor (constructor flag) has no initial removals: the anchor
+ * is the set of buckets used so far, M, and the capacity is only the size
+ * of the arrays, C. When no removed bucket is left, UpdateNewBucket appends
+ * bucket M to the anchor and doubles the arrays if they are full; Reserve
+ * grows them ahead of time. The first hash is reduced to the anchor with
+ * FlipHash instead of a modulo, so that growing M by one only moves keys to
+ * the new bucket: the slots beyond M are never read, and growing the arrays
+ * leaves every key where it was. The keys are mapped differently from a
+ * fixed anchor.
+ *
+ * With the translation cache (constructor flag), ComputeTranslation keeps
+ * for each bucket j the result of its last translation and the range of
+ * A(i) for which it holds: along a K chain A decreases, so the result is the
+ * same for every i with A(i) in (A(result), A(previous)]. The shortcuts are
+ * filled by the lookups and dropped at every update by bumping an epoch.
+ * Only ComputeBucket uses them.
+ */
+template <typename Index = uint32_t, bool Interleaved = false, bool FastMod = false, bool Lazy = false>
 class AnchorHashQre {
 	
   private:
+
+	// Lookup fields of a bucket (interleaved layout): the size of a slot
+	// divides the cache line, so that a slot never straddles two lines
+	struct alignas(2 * sizeof(Index)) Slot {
+		Index a;
+		Index k;
+	};
+
+	// Last translation of a bucket, valid for lo < A(i) <= hi
+	struct Shortcut {
+		Index to;
+		Index lo;
+		Index hi;
+		uint32_t epoch;
+	};
+
+	// Entry of an array whose stored value is XORed with the initial one
+	class Entry {
+	  public:
+		Entry(Index& stored, Index initial) : stored(stored), initial(initial) {}
+		operator uint32_t() const { return stored ^ initial; }
+		Entry& operator= (uint32_t value) { stored = value ^ initial; return *this; }
+		Entry& operator= (const Entry& other) { return *this = static_cast<uint32_t>(other); }
+	  private:
+		Index& stored;
+		Index initial;
+	};
 	
-	// Anchor		
-	uint32_t *A;
+	// Anchor (split layout)
+	Index *A_;
 
 	// Working
-	uint32_t *W;
+	Index *W_;
 
 	// Last appearance 
-	uint32_t *L;
+	Index *L_;
+
+	// "Map diagonal" (split layout)
+	Index *K_;
 
-	// "Map diagonal"	
-	uint32_t *K;
+	// Anchor and "map diagonal" (interleaved layout)
+	Slot *AK;
 	       			
 	// Size of the anchor
 	uint32_t M;
 		
 	// Size of the working
 	uint32_t N;
+
+	// Initial size of the working (lazy initialization)
+	uint32_t N0;
 	
 	// Removed buckets
-	std::stack<uint32_t> r;
+	std::stack<Index> r;
+
+	// Initial removals not restored yet, restored after the stack: [R, M)
+	uint32_t R;
+
+	// Size of the arrays (growable anchor)
+	uint32_t C;
+
+	// The anchor grows instead of having initial removals
+	bool growable;
+
+	// Translation cache (null without cache)
+	Shortcut *S;
+
+	// Updates so far, a shortcut of an older epoch is stale
+	uint32_t epoch;
+
+	Index* APtr(uint32_t b) {
+		if constexpr (Interleaved) return &AK[b].a;
+		else return &A_[b];
+	}
+
+	Index* KPtr(uint32_t b) {
+		if constexpr (Interleaved) return &AK[b].k;
+		else return &K_[b];
+	}
+
+	// Initially the working buckets have A = 0 and the removed ones A = b
+	decltype(auto) A(uint32_t b) {
+		if constexpr (Lazy) return Entry(*APtr(b), b >= N0 ? b : 0);
+		else return *APtr(b);
+	}
+
+	decltype(auto) K(uint32_t b) {
+		if constexpr (Lazy) return Entry(*KPtr(b), b);
+		else return *KPtr(b);
+	}
+
+	decltype(auto) W(uint32_t b) {
+		if constexpr (Lazy) return Entry(W_[b], b);
+		else return W_[b];
+	}
+
+	decltype(auto) L(uint32_t b) {
+		if constexpr (Lazy) return Entry(L_[b], b);
+		else return L_[b];
+	}
+
+	template <typename T>
+	static T* Allocate(uint32_t);
+
+	template <typename T>
+	static void Release(T*);
+
+	// Moves the first n entries to a new array of size c
+	template <typename T>
+	static T* Reallocate(T*, uint32_t n, uint32_t c);
+
+	// Uniform reduction of a hash to [0, n)
+	static uint32_t Reduce(uint32_t hash, uint32_t n) {
+		if constexpr (FastMod) return (static_cast<uint64_t>(hash) * n) >> 32;
+		else return hash % n;
+	}
+
+	// First bucket of a key, uniform on the anchor
+	uint32_t First(uint32_t hash) const {
+		if (growable) return FlipHashEngine::bucketOf(hash, M);
+		else return Reduce(hash, M);
+	}
+
             
 	// Translation oracle
 	uint32_t ComputeTranslation(uint32_t i , uint32_t j);
+
+	// Drops the shortcuts of the translation cache
+	void Invalidate();
 					
   public:
   
-	AnchorHashQre (uint32_t, uint32_t);
+	AnchorHashQre (uint32_t, uint32_t, bool growable = false, bool cached = false);
+
+	AnchorHashQre (const AnchorHashQre&) = delete;
+
+	AnchorHashQre& operator= (const AnchorHashQre&) = delete;
 	
 	~AnchorHashQre();
 		
 	uint32_t ComputeBucket(uint64_t, uint64_t);
+
+	// Same as ComputeBucket for a batch of keys sharing the second key
+	void ComputeBuckets(const uint64_t*, uint64_t, uint32_t*, size_t);
         
 	uint32_t UpdateRemoval(uint32_t);
     
 	uint32_t UpdateNewBucket();
+
+	// Grows the arrays of a growable anchor to the given capacity
+	void Reserve(uint32_t);
            
 };
@@ -15,15 +15,56 @@
  */
 #ifndef ANCHORENGINE_H
 #define ANCHORENGINE_H
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <variant>
 #include "AnchorHashQre.hpp"
+#include "../utils.h"
 
-class AnchorEngine final {
+/*
+ * AnchorHash engine. With FastMod, the hashes are reduced to the anchor and
+ * to the removal levels with a multiply-shift instead of a division: the
+ * mapping of the keys differs from the original AnchorHash, but keeps its
+ * balance and minimal disruption (see AnchorHashQre).
+ */
+template <bool FastMod = false>
+class BasicAnchorEngine final {
 public:
-    // anchor_set = capacity
-    // working_set = size
-    AnchorEngine(uint32_t anchor_set, uint32_t working_set)
-        : m_anchor{anchor_set, working_set}
-    {}
+    /**
+     * Creates a new Anchor engine.
+     *
+     * @param anchor_set capacity of the anchor
+     * @param working_set initial number of working buckets
+     * @param args algorithm arguments (layout: split, default, or
+     *        interleaved; index-width: 16 or 32, by default 16 when the
+     *        capacity is at most 65,536 buckets; init: eager, default, or
+     *        lazy for a construction in constant time; growable: true for
+     *        an anchor that grows past its capacity, always 32-bit wide;
+     *        translation-cache: true to memoize the translations of the
+     *        scalar lookups, see AnchorHashQre)
+     */
+    BasicAnchorEngine(uint32_t anchor_set, uint32_t working_set, const engine_arguments& args = {})
+    {
+        const bool interleaved = args.count("layout") && args.at("layout") == "interleaved";
+        const bool lazy = args.count("init") && args.at("init") == "lazy";
+        const bool growable = args.count("growable") && args.at("growable") == "true";
+        const bool cached = args.count("translation-cache") && args.at("translation-cache") == "true";
+        uint32_t width = anchor_set <= MAX_NARROW_CAPACITY ? 16 : 32;
+        if (args.count("index-width")) {
+            width = str_to<uint32_t>(args.at("index-width"), width);
+        }
+        if (width == 16 && (anchor_set > MAX_NARROW_CAPACITY || growable)) {
+            width = 32;
+        }
+
+        if (width == 16) {
+            emplace<uint16_t>(interleaved, lazy, growable, cached, anchor_set, working_set);
+        }
+        else {
+            emplace<uint32_t>(interleaved, lazy, growable, cached, anchor_set, working_set);
+        }
+    }
 
     /**
    * Returns the bucket where the given key should be mapped.
@@ -35,7 +76,27 @@ public:
    */
     uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) noexcept
     {
-        return m_anchor.ComputeBucket(key, seed);
+        return visit([&](auto& anchor) { return anchor.ComputeBucket(key, seed); });
+    }
+
+    /**
+   * Maps a batch of keys to their buckets.
+   * Up to 16 lookups are in flight at once and each of them prefetches the
+   * next slot of A or K it needs, so that the cache misses of different keys
+   * overlap (see AnchorHashQre::ComputeBuckets). This pays off when the
+   * capacity is large and the arrays do not fit in the cache.
+   * The result for each key is the same as getBucketCRC32c(keys[i], seed).
+   *
+   * @param keys the keys to map
+   * @param seed the initial seed for CRC32c
+   * @param out the related buckets (at least keys.size() entries)
+   */
+    void getBucketsCRC32c(std::span<const uint64_t> keys, uint64_t seed,
+        std::span<uint32_t> out) noexcept
+    {
+        visit([&](auto& anchor) {
+            anchor.ComputeBuckets(keys.data(), seed, out.data(), keys.size());
+        });
     }
 
     /**
@@ -43,7 +104,23 @@ public:
    *
    * @return the added bucket
    */
-    uint32_t addBucket() noexcept { return m_anchor.UpdateNewBucket(); }
+    uint32_t addBucket()
+    {
+        return visit([](auto& anchor) { return anchor.UpdateNewBucket(); });
+    }
+
+    /**
+   * Grows the capacity of a growable anchor (see the growable argument)
+   * without moving any key: only the slots of future buckets are added.
+   * addBucket also grows it, doubling the capacity, when it is full.
+   * The capacity of the other anchors is fixed and this does nothing.
+   *
+   * @param capacity the new capacity
+   */
+    void reserve(uint32_t capacity)
+    {
+        visit([=](auto& anchor) { anchor.Reserve(capacity); });
+    }
 
     /**
    * Removes the given bucket from the engine.
@@ -53,12 +130,52 @@ public:
    */
     uint32_t removeBucket(uint32_t bucket) noexcept
     {
-        m_anchor.UpdateRemoval(bucket);
+        visit([=](auto& anchor) { anchor.UpdateRemoval(bucket); });
         return bucket;
     }
 
 private:
-  AnchorHashQre m_anchor;
+
+    template <typename Index, bool Interleaved, bool Lazy>
+    using Anchor = AnchorHashQre<Index, Interleaved, FastMod, Lazy>;
+
+    /* Largest capacity whose bucket indices fit in 16 bits */
+    static constexpr uint32_t MAX_NARROW_CAPACITY = 1u << 16;
+
+    template <typename Index>
+    void emplace(bool interleaved, bool lazy, bool growable, bool cached,
+        uint32_t anchor_set, uint32_t working_set)
+    {
+        if (interleaved) {
+            if (lazy) m_anchor.template emplace<Anchor<Index, true, true>>(anchor_set, working_set, growable, cached);
+            else m_anchor.template emplace<Anchor<Index, true, false>>(anchor_set, working_set, growable, cached);
+        }
+        else {
+            if (lazy) m_anchor.template emplace<Anchor<Index, false, true>>(anchor_set, working_set, growable, cached);
+            else m_anchor.template emplace<Anchor<Index, false, false>>(anchor_set, working_set, growable, cached);
+        }
+    }
+
+    // Calls f on the anchor, the alternative never changes after construction.
+    template <std::size_t I = 1, typename F>
+    auto visit(F&& f) -> decltype(f(std::declval<Anchor<uint32_t, false, false>&>()))
+    {
+        if constexpr (I + 1 < std::variant_size_v<decltype(m_anchor)>) {
+            if (m_anchor.index() != I) {
+                return visit<I + 1>(std::forward<F>(f));
+            }
+        }
+        return f(*std::get_if<I>(&m_anchor));
+    }
+
+    std::variant<std::monostate,
+        Anchor<uint16_t, false, false>, Anchor<uint32_t, false, false>,
+        Anchor<uint16_t, true, false>, Anchor<uint32_t, true, false>,
+        Anchor<uint16_t, false, true>, Anchor<uint32_t, false, true>,
+        Anchor<uint16_t, true, true>, Anchor<uint32_t, true, true>> m_anchor;
 };
 
+using AnchorEngine = BasicAnchorEngine<false>;
+using AnchorFastModEngine = BasicAnchorEngine<true>;
+
 #endif // ANCHORENGINE_H
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BINOMIALENGINE_H
+#define BINOMIALENGINE_H
+#include <cstdint>
+#include "../utils.h"
+
+/*
+ * BinomialHash (M. Coluzzi, A. Brocco, A. Antonucci, T. Leu, 2024).
+ *
+ * Buckets are seen as a binomial tree of 2^k nodes, where 2^k is the smallest
+ * power of two >= size. The lower tree [0, 2^(k-1)[ is always working, the
+ * upper level [2^(k-1), 2^k[ is only partially working. A key is mapped with a
+ * mask on the whole tree; if it hits a non-working bucket it is rehashed a
+ * bounded number of times, and if it never hits a working bucket of the upper
+ * level it falls back to the lower tree. Positions inside each level are
+ * shuffled by a level-dependent hash to avoid correlations between levels.
+ */
+class BinomialEngine final {
+public:
+    BinomialEngine(uint32_t, uint32_t working_set)
+        : m_n{working_set}
+    {
+        updateFilters();
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        return lookup(crc32c_sse42_u64(key, seed), m_n, m_upperTreeFilter, m_lowerTreeFilter);
+    }
+
+    /**
+   * Maps an already computed hash to a bucket in [0, n-1].
+   * Used by the engines built on top of Binomial (e.g. Memento).
+   *
+   * @param hash the hash of the key
+   * @param n the number of buckets
+   * @return the related bucket
+   */
+    static uint32_t bucketOf(uint64_t hash, uint32_t n) noexcept
+    {
+        const uint32_t upperTreeFilter = n < 2 ? 0 : smallestPow2(n) - 1;
+        return lookup(hash, n, upperTreeFilter, upperTreeFilter >> 1);
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket() noexcept
+    {
+        ++m_n;
+        updateFilters();
+        return m_n - 1;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Since Binomial does not support random removals, it will always remove the
+   * last bucket.
+   *
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t) noexcept
+    {
+        --m_n;
+        updateFilters();
+        return m_n;
+    }
+
+private:
+
+    /* Maximum number of rehashes before falling back to the lower tree */
+    static constexpr int MAX_REHASHES = 8;
+
+    static uint32_t lookup(uint64_t hash, uint32_t n, uint32_t upperTreeFilter, uint32_t lowerTreeFilter) noexcept
+    {
+        if (n < 2) {
+            return 0;
+        }
+
+        uint32_t b = relocateWithinLevel(static_cast<uint32_t>(hash) & upperTreeFilter, hash);
+        if (b < n) {
+            return b;
+        }
+
+        // The bucket is in the non-working part of the upper level: we try
+        // again, accepting only working buckets of the upper level.
+        uint64_t h = hash;
+        for (int i = 0; i < MAX_REHASHES; ++i) {
+            h = rehash(h, 32);
+            b = relocateWithinLevel(static_cast<uint32_t>(h) & upperTreeFilter, h);
+            if (b <= lowerTreeFilter) {
+                break;
+            }
+            if (b < n) {
+                return b;
+            }
+        }
+
+        // Same bucket the key had before the upper level was added.
+        return relocateWithinLevel(static_cast<uint32_t>(hash) & lowerTreeFilter, hash);
+    }
+
+    void updateFilters() noexcept
+    {
+        m_upperTreeFilter = m_n < 2 ? 0 : smallestPow2(m_n) - 1;
+        m_lowerTreeFilter = m_upperTreeFilter >> 1;
+    }
+
+    static uint32_t smallestPow2(uint32_t x) noexcept
+    {
+        --x;
+        x |= x >> 1;
+        x |= x >> 2;
+        x |= x >> 4;
+        x |= x >> 8;
+        x |= x >> 16;
+        return x + 1;
+    }
+
+    // Moves the bucket to a position of the same level [2^i, 2^(i+1)[ that
+    // depends only on the hash and on the level.
+    static uint32_t relocateWithinLevel(uint32_t bucket, uint64_t hash) noexcept
+    {
+        if (bucket < 2) {
+            return bucket;
+        }
+        const uint32_t level = 31 - __builtin_clz(bucket);
+        const uint32_t levelBase = static_cast<uint32_t>(1) << level;
+        return levelBase + (static_cast<uint32_t>(rehash(hash, level)) & (levelBase - 1));
+    }
+
+    static uint64_t rehash(uint64_t hash, uint32_t salt) noexcept
+    {
+        uint64_t z = hash + (static_cast<uint64_t>(salt) + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /* Number of nodes in the cluster */
+    uint32_t m_n;
+
+    /* Smallest power of 2 greater or equal to n, minus 1 */
+    uint32_t m_upperTreeFilter;
+
+    /* Half of the smallest power of 2 greater or equal to n, minus 1 */
+    uint32_t m_lowerTreeFilter;
+};
+
+#endif // BINOMIALENGINE_H
@@ -15,40 +15,102 @@
  */
 #ifndef DXENGINE_H
 #define DXENGINE_H
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <boost/dynamic_bitset.hpp>
+#include "../anchor/anchorengine.h"
 #include "../utils.h"
 #include <deque>
+#include <memory>
 #include <random>
 #include <pcg_random.hpp>
 
 
+/*
+ * DxHash engine. A key probes random buckets of the capacity until it finds
+ * a working one: the number of probes is geometric, with a mean of
+ * capacity / size, and its tail grows with the capacity factor and the
+ * removals.
+ *
+ * With growable (engine argument), the capacity starts at the given one (or
+ * at the working set, e.g. with capacity: 1) and doubles when an addition
+ * finds no free bucket, as the NSArray of the DxHash paper. The probes
+ * follow two levels of choice so that a doubling moves no key: at capacity
+ * C0 * 2^L, a probe first draws whether it falls in the upper half
+ * [C0 * 2^(L-1), C0 * 2^L), then a bucket of that half; otherwise it takes
+ * the next probe of the sequence of capacity C0 * 2^(L-1), in the same way
+ * down to C0. Each level has its own stream of draws, so that removing the
+ * upper half from the sequence of a key gives back the sequence it had
+ * before the doubling: the probes that are added only hit buckets that were
+ * never used, and the first working bucket stays the same. The probes are
+ * uniform over the capacity, which stays below twice the buckets used,
+ * instead of being sized for the largest cluster.
+ *
+ * With max-probes (engine argument), a key gives up after that many failed
+ * probes and is mapped by a growable AnchorHash of the same working set
+ * instead: a dense index of the working buckets, compacted at every removal,
+ * that spans the buckets used so far rather than the whole capacity, so that
+ * its lookup does not depend on the capacity factor. Both engines restore
+ * the last removed bucket first and otherwise the first unused one, so that
+ * they always have the same working set and the mapping stays consistent
+ * with minimal disruption: a removal only moves the keys of the removed
+ * bucket, and an addition only moves keys to the added one. When growable,
+ * the probes of buckets never used do not count, since a doubling adds them.
+ */
 class DxEngine final {
 public:
-    explicit DxEngine(uint32_t capacity, uint32_t size)
+    /**
+     * Creates a new Dx engine.
+     *
+     * @param capacity the number of buckets that can be working (the
+     *        initial one when growable)
+     * @param size initial number of working buckets
+     * @param args algorithm arguments (max-probes: number of failed probes
+     *        before the fallback to the dense index, 0 (default) to probe
+     *        without bound; it cannot change once the keys are mapped;
+     *        growable: true to double the capacity when it is full)
+     */
+    DxEngine(uint32_t capacity, uint32_t size, const engine_arguments& args = {})
         : m_size(size), m_capacity(capacity)
     {
+        m_growable = args.count("growable") && args.at("growable") == "true";
+        if (m_growable) {
+            m_capacity = m_initialCapacity = std::max({ capacity, size, 1u });
+        }
         m_failed.resize(m_capacity, 0);
         m_failed.set(size, m_capacity - size, 1);  
         m_distribution = std::uniform_int_distribution<uint32_t>(0, m_capacity-1);
+        m_counted = m_growable ? size : m_capacity;
+        if (args.count("max-probes")) {
+            m_maxProbes = str_to<uint32_t>(args.at("max-probes"), 0);
+        }
+        if (m_maxProbes) {
+            m_fallback = std::make_unique<AnchorEngine>(std::max(size, 1u), size,
+                engine_arguments{ { "growable", "true" }, { "layout", "interleaved" } });
+        }
     }
 
     uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) {
         auto hashValue = crc32c_sse42_u64(key, seed);
+        if (m_growable) {
+            std::array<uint32_t, MAX_LEVELS + 1> steps{};
+            return probe(key, seed, [&] { return levelProbe(hashValue, steps); });
+        }
+
         pcg32 rng;
         rng.seed(hashValue);
-        uint32_t b = m_distribution(rng);
-        
-        while (m_failed.test(b)) {
-            b = m_distribution(rng);  
-        }
-        return b;
+        return probe(key, seed, [&] { return m_distribution(rng); });
     }
 
     uint32_t addBucket() {
         uint32_t b;
         if (m_removed.empty()) {
             b = m_size;
+            if (m_growable && b == m_capacity) {
+                grow();
+            }
+            m_counted = std::max(m_counted, b + 1);
         }
         else {
             b = m_removed.front();
@@ -56,6 +118,10 @@ public:
         }
         m_failed.reset(b);
         ++m_size;
+        if (m_fallback) {
+            // Same order: the anchor restores (or appends) b as well
+            m_fallback->addBucket();
+        }
 
         return b;
     }
@@ -64,6 +130,9 @@ public:
         --m_size;
         m_failed.set(b);
         m_removed.push_front(b);
+        if (m_fallback) {
+            m_fallback->removeBucket(b);
+        }
 
         return b;
     }
@@ -76,13 +145,80 @@ public:
         return m_capacity;
     }
 
+    uint32_t maxProbes() const noexcept {
+        return m_maxProbes;
+    }
+
 
 private:
+    /* Doublings of a growable engine whose capacity still fits 32 bits */
+    static constexpr uint32_t MAX_LEVELS = 31;
+
+    // First working bucket of the probes returned by next, or the bucket of
+    // the fallback after max-probes failed probes below m_counted.
+    template <typename Next>
+    uint32_t probe(uint64_t key, uint64_t seed, Next&& next) {
+        uint32_t b = next();
+
+        if (m_maxProbes) {
+            for (uint32_t probes = 0; m_failed.test(b); b = next()) {
+                if (b < m_counted && ++probes == m_maxProbes) {
+                    return m_fallback->getBucketCRC32c(key, seed);
+                }
+            }
+            return b;
+        }
+
+        while (m_failed.test(b)) {
+            b = next();
+        }
+        return b;
+    }
+
+    // Next probe of a growable engine, steps[l] counting the draws of level l.
+    uint32_t levelProbe(uint64_t hash, std::array<uint32_t, MAX_LEVELS + 1>& steps) const noexcept {
+        for (uint32_t level = m_levels; level > 0; --level) {
+            const uint64_t z = draw(hash, level, steps[level]++);
+            if (z >> 63) {
+                const uint32_t half = m_initialCapacity << (level - 1);
+                return half + reduce(static_cast<uint32_t>(z), half);
+            }
+        }
+        return reduce(static_cast<uint32_t>(draw(hash, 0, steps[0]++)), m_initialCapacity);
+    }
+
+    // Doubles the capacity, the new buckets are not working.
+    void grow() {
+        ++m_levels;
+        m_capacity <<= 1;
+        m_failed.resize(m_capacity, 1);
+    }
+
+    // Maps a 32-bit random value to [0, range-1] without a division.
+    static uint32_t reduce(uint32_t random, uint32_t range) noexcept {
+        return static_cast<uint32_t>((static_cast<uint64_t>(random) * range) >> 32);
+    }
+
+    // Pseudo-random value depending only on the key, the level and the step.
+    static uint64_t draw(uint64_t hash, uint32_t level, uint32_t step) noexcept {
+        uint64_t z = hash + ((static_cast<uint64_t>(level) << 32 | step) + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
     uint32_t m_size;
     uint32_t m_capacity;
     boost::dynamic_bitset<> m_failed;
     std::deque<uint32_t> m_removed;
     std::uniform_int_distribution<uint32_t> m_distribution;
+    uint32_t m_maxProbes{0};
+    std::unique_ptr<AnchorEngine> m_fallback;
+    bool m_growable{false};
+    uint32_t m_initialCapacity{0};
+    uint32_t m_levels{0};
+    // Bound of the buckets whose failed probes count toward max-probes
+    uint32_t m_counted;
 };
 
 
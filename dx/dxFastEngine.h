@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2023 Amos Brocco, Tony Kolarek, Tatiana Dal Busco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DXFASTENGINE_H
+#define DXFASTENGINE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+#include <immintrin.h>
+#include "../utils.h"
+
+/*
+ * DxHash with the same probe sequence as DxEngine (a pcg32 stream seeded
+ * with the hash of the key), but without its generic machinery:
+ *  - the pcg32 (XSH RR 64/32) steps are computed inline;
+ *  - a draw is reduced to [0, capacity[ with a multiply and a shift instead
+ *    of the rejection sampling and the division of uniform_int_distribution;
+ *  - the failed buckets are tested in a plain array of 64-bit words.
+ * The buckets differ from DxEngine's (the range reduction is not the same),
+ * but the engine is a DxHash all the same: a key stays on its bucket until
+ * that bucket fails.
+ */
+class DxFastEngine final {
+public:
+    DxFastEngine(uint32_t capacity, uint32_t size)
+        : m_size{size}, m_capacity{capacity}, m_failed((capacity + 63) / 64)
+    {
+        for (uint32_t b = size; b < capacity; ++b) {
+            setFailed(b);
+        }
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        uint64_t state = seedState(crc32c_sse42_u64(key, seed));
+        uint32_t b = reduce(next(state));
+        while (failed(b)) {
+            b = reduce(next(state));
+        }
+        return b;
+    }
+
+    /**
+   * Maps a batch of keys to their buckets.
+   * The probe loop runs for 16 keys at once with AVX-512 (8 with AVX2), one
+   * pcg32 stream per 64-bit SIMD lane, and the failed buckets are tested
+   * with a gather. A lane takes the next key as soon as it draws a working
+   * bucket. Without AVX2, the keys go through the scalar version.
+   * The result for each key is the same as getBucketCRC32c(keys[i], seed).
+   *
+   * @param keys the keys to map
+   * @param seed the initial seed for CRC32c
+   * @param out the related buckets (at least keys.size() entries)
+   */
+    void getBucketsCRC32c(std::span<const uint64_t> keys, uint64_t seed,
+        std::span<uint32_t> out) const noexcept
+    {
+        std::size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__BMI2__)
+        for (; i < keys.size(); i += CHUNK_SIZE) {
+            const auto n = static_cast<uint32_t>(std::min<std::size_t>(CHUNK_SIZE, keys.size() - i));
+            probeChunkAVX512(&keys[i], seed, &out[i], n);
+        }
+#elif defined(__AVX2__) && defined(__BMI2__)
+        for (; i < keys.size(); i += CHUNK_SIZE) {
+            const auto n = static_cast<uint32_t>(std::min<std::size_t>(CHUNK_SIZE, keys.size() - i));
+            probeChunkAVX2(&keys[i], seed, &out[i], n);
+        }
+#endif
+        for (; i < keys.size(); ++i) {
+            out[i] = getBucketCRC32c(keys[i], seed);
+        }
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket()
+    {
+        uint32_t b;
+        if (m_removed.empty()) {
+            b = m_size;
+        }
+        else {
+            b = m_removed.front();
+            m_removed.pop_front();
+        }
+        m_failed[b >> 6] &= ~(static_cast<uint64_t>(1) << (b & 63));
+        ++m_size;
+
+        return b;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   *
+   * @param b the bucket to remove
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t b)
+    {
+        --m_size;
+        setFailed(b);
+        m_removed.push_front(b);
+
+        return b;
+    }
+
+    uint32_t size() const noexcept { return m_size; }
+
+    uint32_t capacity() const noexcept { return m_capacity; }
+
+private:
+
+    /* Keys seeded at once by the batched lookup */
+    static constexpr uint32_t CHUNK_SIZE = 1024;
+
+    static constexpr uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+    static constexpr uint64_t PCG_INCREMENT = 1442695040888963407ULL;
+
+    // State of a pcg32 seeded with the hash (as pcg32::seed does).
+    static uint64_t seedState(uint64_t hash) noexcept
+    {
+        return (hash + PCG_INCREMENT) * PCG_MULTIPLIER + PCG_INCREMENT;
+    }
+
+    // Next output of the pcg32 stream.
+    static uint32_t next(uint64_t& state) noexcept
+    {
+        const uint64_t old = state;
+        state = old * PCG_MULTIPLIER + PCG_INCREMENT;
+        const uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        const uint32_t rot = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // Maps a 32-bit draw to [0, capacity[.
+    uint32_t reduce(uint32_t x) const noexcept
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(x) * m_capacity) >> 32);
+    }
+
+    bool failed(uint32_t b) const noexcept
+    {
+        return m_failed[b >> 6] >> (b & 63) & 1;
+    }
+
+    void setFailed(uint32_t b) noexcept
+    {
+        m_failed[b >> 6] |= static_cast<uint64_t>(1) << (b & 63);
+    }
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__BMI2__)
+    // Next draws of the active lanes, reduced to [0, capacity[.
+    __m512i drawAVX512(__m512i& state, __mmask8 active) const noexcept
+    {
+        const __m512i old = state;
+        state = _mm512_mask_mov_epi64(state, active, _mm512_add_epi64(
+            _mm512_mullo_epi64(old, _mm512_set1_epi64(PCG_MULTIPLIER)),
+            _mm512_set1_epi64(PCG_INCREMENT)));
+        const __m512i xorshifted = _mm512_and_si512(_mm512_srli_epi64(
+            _mm512_xor_si512(_mm512_srli_epi64(old, 18), old), 27), _mm512_set1_epi64(0xFFFFFFFF));
+        const __m512i rot = _mm512_srli_epi64(old, 59);
+        const __m512i x = _mm512_and_si512(_mm512_or_si512(_mm512_srlv_epi64(xorshifted, rot),
+            _mm512_sllv_epi64(xorshifted, _mm512_and_si512(_mm512_sub_epi64(_mm512_setzero_si512(), rot),
+                _mm512_set1_epi64(31)))), _mm512_set1_epi64(0xFFFFFFFF));
+        return _mm512_srli_epi64(_mm512_mul_epu32(x, _mm512_set1_epi64(m_capacity)), 32);
+    }
+
+    /*
+     * The lanes do not run in lockstep: the number of probes of a key is
+     * geometric (capacity / size on average), so a group would wait for its
+     * slowest key. Instead, a lane that finds its bucket scatters it to out
+     * and is refilled with the next key of the chunk (expand loads).
+     */
+    void probeChunkAVX512(const uint64_t* keys, uint64_t seed, uint32_t* out, uint32_t n) const noexcept
+    {
+        alignas(64) uint64_t states[CHUNK_SIZE];
+        for (uint32_t l = 0; l < n; ++l) {
+            states[l] = seedState(crc32c_sse42_u64(keys[l], seed));
+        }
+
+        const __m512i one = _mm512_set1_epi64(1);
+        const __m512i low = _mm512_set1_epi64(63);
+        const __m512i lanes = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+        const auto* words = reinterpret_cast<const long long*>(m_failed.data());
+
+        __m512i s[2], index[2];
+        __mmask8 active[2];
+        uint32_t next = 0;
+        for (int v = 0; v < 2; ++v) {
+            active[v] = static_cast<__mmask8>(_bzhi_u32(0xFF, std::min(n - next, 8u)));
+            s[v] = _mm512_maskz_expandloadu_epi64(active[v], states + next);
+            index[v] = _mm512_add_epi64(_mm512_set1_epi64(next), lanes);
+            next += _mm_popcnt_u32(active[v]);
+        }
+
+        while (active[0] | active[1]) {
+            for (int v = 0; v < 2; ++v) {
+                const __m512i d = drawAVX512(s[v], active[v]);
+                const __m512i word = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), active[v],
+                    _mm512_srli_epi64(d, 6), words, 8);
+                const __mmask8 failed = _mm512_mask_test_epi64_mask(active[v],
+                    _mm512_srlv_epi64(word, _mm512_and_si512(d, low)), one);
+                const __mmask8 done = active[v] & ~failed;
+                if (done) {
+                    _mm512_mask_i64scatter_epi32(out, done, index[v], _mm512_cvtepi64_epi32(d), 4);
+                    const __mmask8 refill = static_cast<__mmask8>(_pdep_u32(
+                        _bzhi_u32(0xFF, std::min(n - next, 8u)), done));
+                    s[v] = _mm512_mask_expandloadu_epi64(s[v], refill, states + next);
+                    index[v] = _mm512_mask_expand_epi64(index[v], refill,
+                        _mm512_add_epi64(_mm512_set1_epi64(next), lanes));
+                    next += _mm_popcnt_u32(refill);
+                    active[v] = failed | refill;
+                }
+            }
+        }
+    }
+#elif defined(__AVX2__) && defined(__BMI2__)
+    // AVX2 has no 64-bit multiply, so we build it from 32x32->64 products.
+    static __m256i mullo64(__m256i a, __m256i b) noexcept
+    {
+        const __m256i lo = _mm256_mul_epu32(a, b);
+        const __m256i hi = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+            _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+        return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    }
+
+    // Next draws of the lanes, reduced to [0, capacity[.
+    __m256i drawAVX2(__m256i& state) const noexcept
+    {
+        const __m256i old = state;
+        state = _mm256_add_epi64(mullo64(old, _mm256_set1_epi64x(PCG_MULTIPLIER)),
+            _mm256_set1_epi64x(PCG_INCREMENT));
+        const __m256i xorshifted = _mm256_and_si256(_mm256_srli_epi64(
+            _mm256_xor_si256(_mm256_srli_epi64(old, 18), old), 27), _mm256_set1_epi64x(0xFFFFFFFF));
+        const __m256i rot = _mm256_srli_epi64(old, 59);
+        const __m256i x = _mm256_and_si256(_mm256_or_si256(_mm256_srlv_epi64(xorshifted, rot),
+            _mm256_sllv_epi64(xorshifted, _mm256_and_si256(_mm256_sub_epi64(_mm256_setzero_si256(), rot),
+                _mm256_set1_epi64x(31)))), _mm256_set1_epi64x(0xFFFFFFFF));
+        return _mm256_srli_epi64(_mm256_mul_epu32(x, _mm256_set1_epi64x(m_capacity)), 32);
+    }
+
+    /*
+     * Same scheme as the AVX-512 version, but AVX2 has neither expand loads
+     * nor scatters: the lanes live in small arrays, and the lanes that found
+     * their bucket are written out and refilled one by one. A draw is always
+     * below the capacity, so the lanes without a key can keep drawing.
+     */
+    void probeChunkAVX2(const uint64_t* keys, uint64_t seed, uint32_t* out, uint32_t n) const noexcept
+    {
+        alignas(32) uint64_t states[CHUNK_SIZE];
+        for (uint32_t l = 0; l < n; ++l) {
+            states[l] = seedState(crc32c_sse42_u64(keys[l], seed));
+        }
+
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i low = _mm256_set1_epi64x(63);
+        const auto* words = reinterpret_cast<const long long*>(m_failed.data());
+
+        alignas(32) uint64_t lane_states[8] = {};
+        alignas(32) uint64_t draws[8];
+        uint32_t lane_keys[8];
+        uint32_t next = std::min(n, 8u);
+        uint32_t live = _bzhi_u32(0xFF, next);
+        for (uint32_t l = 0; l < next; ++l) {
+            lane_states[l] = states[l];
+            lane_keys[l] = l;
+        }
+
+        while (live) {
+            uint32_t done = 0;
+            for (int v = 0; v < 2; ++v) {
+                __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(lane_states + 4 * v));
+                const __m256i d = drawAVX2(s);
+                const __m256i word = _mm256_i64gather_epi64(words, _mm256_srli_epi64(d, 6), 8);
+                const __m256i bit = _mm256_and_si256(_mm256_srlv_epi64(word, _mm256_and_si256(d, low)), one);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lane_states + 4 * v), s);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(draws + 4 * v), d);
+                done |= static_cast<uint32_t>(_mm256_movemask_pd(
+                    _mm256_castsi256_pd(_mm256_cmpeq_epi64(bit, _mm256_setzero_si256())))) << (4 * v);
+            }
+            for (done &= live; done; done &= done - 1) {
+                const uint32_t l = __builtin_ctz(done);
+                out[lane_keys[l]] = static_cast<uint32_t>(draws[l]);
+                if (next < n) {
+                    lane_states[l] = states[next];
+                    lane_keys[l] = next++;
+                }
+                else {
+                    live &= ~(1u << l);
+                }
+            }
+        }
+    }
+#endif
+
+    uint32_t m_size;
+    uint32_t m_capacity;
+    std::vector<uint64_t> m_failed;
+    std::deque<uint32_t> m_removed;
+};
+
+#endif // DXFASTENGINE_H
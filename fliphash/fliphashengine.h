@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FLIPHASHENGINE_H
+#define FLIPHASHENGINE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <xxhash.h>
+
+/*
+ * FlipHash (C. Masson, H. Lee, 2024).
+ *
+ * For a power of two range 2^r, a key takes the r lowest bits of its hash and
+ * flips, with a second hash, all the bits below the highest set one: a key
+ * stays in [2^(b-1), 2^b[ when the range grows, unless it moves to the new
+ * level. Any other range n is handled inside its enclosing power of two
+ * 2^r: a key landing in [n, 2^r[ draws again in [0, 2^r[ until it either hits
+ * [2^(r-1), n[ or falls in the lower half, where it takes its position in
+ * the range 2^(r-1). The expected number of draws is constant, and only
+ * integer operations are used.
+ *
+ * Unlike the other engines, the key is hashed on 64 bits with XXH64: all
+ * the draws are derived from the full 64-bit hash.
+ */
+class FlipHashEngine final {
+public:
+    FlipHashEngine(uint32_t, uint32_t working_set)
+        : m_n{working_set}
+    {}
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   * The key is hashed with XXH64, CRC32c is not used.
+   *
+   * @param key the key to map
+   * @param seed the seed of the hash function
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        return bucketOf(XXH64(&key, sizeof(key), seed), m_n);
+    }
+
+    /**
+   * Maps an already computed hash to a bucket in [0, n-1].
+   * Used by the engines built on top of FlipHash (e.g. Memento).
+   *
+   * @param hash the 64-bit hash of the key
+   * @param n the number of buckets
+   * @return the related bucket
+   */
+    static uint32_t bucketOf(uint64_t hash, uint32_t n) noexcept
+    {
+        const uint32_t r = levels(n);
+        const uint32_t d = flipHashPow2(hash, r);
+        return d < n ? d : redraw(hash, r, n);
+    }
+
+    /**
+   * Maps a batch of keys to their buckets.
+   * Keys are processed in groups: the first pass hashes the group and maps
+   * every key in the enclosing power of two range, without branches; the
+   * second pass only redraws the keys beyond the working set (less than half
+   * of them). The result for each key is the same as getBucketCRC32c(keys[i], seed).
+   *
+   * @param keys the keys to map
+   * @param seed the seed of the hash function
+   * @param out the related buckets (same size as keys)
+   */
+    void getBucketsCRC32c(std::span<const uint64_t> keys, uint64_t seed, std::span<uint32_t> out) const noexcept
+    {
+        const uint32_t r = levels(m_n);
+        uint64_t hashes[GROUP_SIZE];
+        for (std::size_t first = 0; first < keys.size(); first += GROUP_SIZE) {
+            const std::size_t count = std::min<std::size_t>(GROUP_SIZE, keys.size() - first);
+            for (std::size_t i = 0; i < count; ++i) {
+                hashes[i] = XXH64(&keys[first + i], sizeof(uint64_t), seed);
+                out[first + i] = flipHashPow2(hashes[i], r);
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                if (out[first + i] >= m_n) {
+                    out[first + i] = redraw(hashes[i], r, m_n);
+                }
+            }
+        }
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket() noexcept { return m_n++; }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Since FlipHash does not support random removals, it will always remove
+   * the last bucket.
+   *
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t) noexcept { return --m_n; }
+
+private:
+
+    /* Keys hashed and mapped at once by the batched lookup */
+    static constexpr std::size_t GROUP_SIZE = 64;
+
+    /* Draws before a key beyond the working set falls back to the lower half */
+    static constexpr uint32_t MAX_DRAWS = 64;
+
+    // Smallest r such that n <= 2^r.
+    static uint32_t levels(uint32_t n) noexcept
+    {
+        return n < 2 ? 0 : 64 - __builtin_clzll(static_cast<uint64_t>(n) - 1);
+    }
+
+    // Pseudo-random value depending only on the hash and the seed.
+    static uint64_t draw(uint64_t hash, uint64_t seed) noexcept
+    {
+        uint64_t z = hash + (seed + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Maps the hash to [0, 2^r[ (r <= 32).
+    static uint32_t flipHashPow2(uint64_t hash, uint32_t r) noexcept
+    {
+        const uint64_t a = hash & ((static_cast<uint64_t>(1) << r) - 1);
+        // The highest set bit stays, the bits below are flipped with the
+        // draw of its level: a | 1 keeps clz defined, 0 and 1 map to themselves.
+        const uint32_t b = 63 - __builtin_clzll(a | 1);
+        const uint64_t low = (static_cast<uint64_t>(1) << b) - 1;
+        return static_cast<uint32_t>((a & ~low) | (draw(hash, b) & low));
+    }
+
+    // Maps a key that fell in [n, 2^r[ inside [0, n[.
+    static uint32_t redraw(uint64_t hash, uint32_t r, uint32_t n) noexcept
+    {
+        const uint64_t mask = (static_cast<uint64_t>(1) << r) - 1;
+        const uint64_t half = static_cast<uint64_t>(1) << (r - 1);
+        for (uint32_t i = 0; i < MAX_DRAWS; ++i) {
+            const uint64_t e = draw(hash, static_cast<uint64_t>(r) << 32 | i) & mask;
+            if (e < half) {
+                break;
+            }
+            if (e < n) {
+                return static_cast<uint32_t>(e);
+            }
+        }
+        return flipHashPow2(hash, r - 1);
+    }
+
+    uint32_t m_n;
+};
+
+#endif // FLIPHASHENGINE_H
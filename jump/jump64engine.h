@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef JUMP64ENGINE_H
+#define JUMP64ENGINE_H
+#include <cstdint>
+#include <xxhash.h>
+#include "jumpengine.h"
+
+/*
+ * Jump consistent hash on a 64-bit hash of the key.
+ *
+ * JumpEngine feeds Jump with the 32-bit CRC32c of the key: at most 2^32
+ * keys are told apart, so that with n buckets each bucket receives about
+ * 2^32/n hash values, and the number it receives varies with a relative
+ * standard deviation of sqrt(n/2^32) (5% at 10^7 buckets) however many
+ * keys are mapped. Here the key is hashed on 64 bits with XXH64, as in
+ * FlipHash, and the whole hash seeds the generator of Jump, which is what
+ * the authors intended.
+ */
+class Jump64Engine final {
+public:
+    Jump64Engine(uint32_t, uint32_t working_set)
+        : m_num_buckets{working_set}
+    {}
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   * The key is hashed with XXH64, CRC32c is not used.
+   *
+   * @param key the key to map
+   * @param seed the seed of the hash function
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        return JumpEngine::bucketOf(XXH64(&key, sizeof(key), seed), m_num_buckets);
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket() noexcept { return m_num_buckets++; }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Since Jump does not support random removals, it will always remove the
+   * last bucket.
+   *
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t) noexcept
+    {
+        return --m_num_buckets;
+    }
+
+private:
+    uint32_t m_num_buckets;
+};
+
+#endif // JUMP64ENGINE_H
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef JUMPBACKENGINE_H
+#define JUMPBACKENGINE_H
+#include <cstdint>
+#include "../utils.h"
+
+/*
+ * JumpBackHash (O. Ertl, 2024).
+ *
+ * Like Jump, a key "jumps" to bucket b with probability 1/(b+1), independently
+ * for every b, and is mapped to the largest jump below the number of buckets.
+ * Instead of walking the jumps forward, JumpBackHash walks them backward from
+ * the top bucket. Buckets are grouped by level, level i being [2^i, 2^(i+1)[:
+ * a level contains at least one jump with probability 1/2, so one random bit
+ * per level tells which levels are non-empty, and the largest jump below any
+ * bound c is uniform in [0, c]. The expected number of steps is constant and
+ * no division is needed.
+ */
+class JumpBackEngine final {
+public:
+    JumpBackEngine(uint32_t, uint32_t working_set)
+        : m_num_buckets{working_set}
+    {}
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        const uint64_t hash = crc32c_sse42_u64(key, seed);
+        const uint32_t max_bucket = m_num_buckets - 1;
+        if (max_bucket == 0) {
+            return 0;
+        }
+
+        // Bit i is set if level i contains at least one jump.
+        uint32_t levels = static_cast<uint32_t>(draw(hash, 32, 0)) & levelMask(max_bucket);
+        if (levels == 0) {
+            return 0;
+        }
+
+        const uint32_t top = 31 - __builtin_clz(max_bucket);
+        if (levels >> top) {
+            // The top level may contain jumps beyond the last bucket: we walk
+            // its jumps backward until we are below the number of buckets.
+            const uint32_t low = static_cast<uint32_t>(1) << top;
+            uint32_t b = low + (static_cast<uint32_t>(draw(hash, top, 0)) & (low - 1));
+            for (uint32_t step = 1; b > max_bucket; ++step) {
+                // The largest jump below b is uniform in [0, b-1].
+                b = reduce(static_cast<uint32_t>(draw(hash, top, step)), b);
+            }
+            if (b >= low) {
+                return b;
+            }
+            levels ^= low;
+            if (levels == 0) {
+                return 0;
+            }
+        }
+
+        // Every bucket of a lower level is working: the result is the
+        // largest jump of the highest non-empty level.
+        const uint32_t level = 31 - __builtin_clz(levels);
+        const uint32_t low = static_cast<uint32_t>(1) << level;
+        return low + (static_cast<uint32_t>(draw(hash, level, 0)) & (low - 1));
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket() noexcept { return m_num_buckets++; }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Since JumpBack does not support random removals, it will always remove the
+   * last bucket.
+   *
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t) noexcept
+    {
+        return --m_num_buckets;
+    }
+
+private:
+
+    // Levels 0..log2(max_bucket), i.e. all levels holding buckets <= max_bucket.
+    static uint32_t levelMask(uint32_t max_bucket) noexcept
+    {
+        return (static_cast<uint32_t>(2) << (31 - __builtin_clz(max_bucket))) - 1;
+    }
+
+    // Maps a 32-bit random value to [0, range-1] without a division.
+    static uint32_t reduce(uint32_t random, uint32_t range) noexcept
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(random) * range) >> 32);
+    }
+
+    // Pseudo-random value depending only on the key, the level and the step,
+    // so that the jumps of a key do not depend on the number of buckets.
+    static uint64_t draw(uint64_t hash, uint32_t level, uint32_t step) noexcept
+    {
+        uint64_t z = hash + ((static_cast<uint64_t>(level) << 32 | step) + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t m_num_buckets;
+};
+
+#endif // JUMPBACKENGINE_H
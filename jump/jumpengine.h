@@ -16,6 +16,11 @@
 #ifndef JUMPENGINE_H
 #define JUMPENGINE_H
 #include <cstdint>
+#include <cstddef>
+#include <span>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
 #include "../utils.h"
 
 class JumpEngine final {
@@ -34,9 +39,21 @@ public:
    */
     uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) noexcept
     {
-        uint64_t hash = crc32c_sse42_u64(key, seed);
+        return bucketOf(crc32c_sse42_u64(key, seed), m_num_buckets);
+    }
+
+    /**
+   * Maps an already computed hash to a bucket in [0, num_buckets-1].
+   * Used by the engines built on top of Jump (e.g. Memento).
+   *
+   * @param hash the hash of the key
+   * @param num_buckets the number of buckets
+   * @return the related bucket
+   */
+    static uint32_t bucketOf(uint64_t hash, uint32_t num_buckets) noexcept
+    {
         int64_t b = 1, j = 0;
-        while (j < m_num_buckets) {
+        while (j < num_buckets) {
             b = j;
             hash = hash * 2862933555777941757ULL + 1;
             j = (b + 1) * (double(1LL << 31) / double((hash >> 33) + 1));
@@ -44,6 +61,37 @@ public:
         return b;
     }
 
+    /**
+   * Maps a batch of keys to their buckets.
+   * The Jump loop runs in lockstep for a group of keys (16 with AVX-512,
+   * 8 with AVX2), one key per SIMD lane. A lane is masked out as soon as its
+   * next jump falls outside the working set, and the group is done when
+   * every lane is masked. Remaining keys, or all of them when no SIMD
+   * extension is available, go through the scalar version.
+   * The result for each key is the same as getBucketCRC32c(keys[i], seed).
+   *
+   * @param keys the keys to map
+   * @param seed the initial seed for CRC32c
+   * @param out the related buckets (at least keys.size() entries)
+   */
+    void getBucketsCRC32c(std::span<const uint64_t> keys, uint64_t seed,
+        std::span<uint32_t> out) noexcept
+    {
+        std::size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+        for (; i + 16 <= keys.size(); i += 16) {
+            jumpLanesAVX512(&keys[i], seed, &out[i]);
+        }
+#elif defined(__AVX2__)
+        for (; i + 8 <= keys.size(); i += 8) {
+            jumpLanesAVX2(&keys[i], seed, &out[i]);
+        }
+#endif
+        for (; i < keys.size(); ++i) {
+            out[i] = getBucketCRC32c(keys[i], seed);
+        }
+    }
+
     /**
    * Adds a new bucket to the engine.
    *
@@ -64,6 +112,105 @@ public:
     }
 
 private:
+
+    /*
+     * The vectorized loops keep b and j as doubles: both are integers below
+     * 2^33, so they are exact, and since the working set size is an integer,
+     * trunc(x) < n holds exactly when x < n. Every step performs the same
+     * IEEE operations as the scalar loop, hence the results are identical.
+     */
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+    void jumpLanesAVX512(const uint64_t* keys, uint64_t seed, uint32_t* out) const noexcept
+    {
+        alignas(64) uint64_t hashes[16];
+        for (int l = 0; l < 16; ++l) {
+            hashes[l] = crc32c_sse42_u64(keys[l], seed);
+        }
+
+        const __m512i mul = _mm512_set1_epi64(2862933555777941757ULL);
+        const __m512i one = _mm512_set1_epi64(1);
+        const __m512d one_d = _mm512_set1_pd(1.0);
+        const __m512d two31 = _mm512_set1_pd(double(1LL << 31));
+        const __m512d n = _mm512_set1_pd(double(m_num_buckets));
+
+        __m512i h[2] = { _mm512_load_si512(hashes), _mm512_load_si512(hashes + 8) };
+        __m512d b[2] = { one_d, one_d };
+        __m512d j[2] = { _mm512_setzero_pd(), _mm512_setzero_pd() };
+        __mmask8 active[2];
+        active[0] = active[1] = _mm512_cmp_pd_mask(j[0], n, _CMP_LT_OQ);
+
+        while (active[0] | active[1]) {
+            for (int v = 0; v < 2; ++v) {
+                b[v] = _mm512_mask_mov_pd(b[v], active[v], j[v]);
+                h[v] = _mm512_add_epi64(_mm512_mullo_epi64(h[v], mul), one);
+                const __m512d d = _mm512_add_pd(_mm512_cvtepu64_pd(_mm512_srli_epi64(h[v], 33)), one_d);
+                const __m512d x = _mm512_mul_pd(_mm512_add_pd(b[v], one_d), _mm512_div_pd(two31, d));
+                j[v] = _mm512_mask_mov_pd(j[v], active[v],
+                    _mm512_roundscale_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+                active[v] = _mm512_mask_cmp_pd_mask(active[v], j[v], n, _CMP_LT_OQ);
+            }
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_cvttpd_epu32(b[0]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8), _mm512_cvttpd_epu32(b[1]));
+    }
+#elif defined(__AVX2__)
+    // AVX2 has no 64-bit multiply, so we build it from 32x32->64 products.
+    static __m256i mullo64(__m256i a, __m256i b) noexcept
+    {
+        const __m256i lo = _mm256_mul_epu32(a, b);
+        const __m256i hi = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+            _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+        return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    }
+
+    void jumpLanesAVX2(const uint64_t* keys, uint64_t seed, uint32_t* out) const noexcept
+    {
+        alignas(32) uint64_t hashes[8];
+        for (int l = 0; l < 8; ++l) {
+            hashes[l] = crc32c_sse42_u64(keys[l], seed);
+        }
+
+        // Integers below 2^52 convert to/from double by adding 2^52 to the bits.
+        const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+        const __m256d magic_d = _mm256_castsi256_pd(magic);
+        const __m256i mul = _mm256_set1_epi64x(2862933555777941757LL);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256d one_d = _mm256_set1_pd(1.0);
+        const __m256d two31 = _mm256_set1_pd(double(1LL << 31));
+        const __m256d n = _mm256_set1_pd(double(m_num_buckets));
+
+        __m256i h[2] = { _mm256_load_si256(reinterpret_cast<const __m256i*>(hashes)),
+                         _mm256_load_si256(reinterpret_cast<const __m256i*>(hashes + 4)) };
+        __m256d b[2] = { one_d, one_d };
+        __m256d j[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+        __m256d active[2];
+        active[0] = active[1] = _mm256_cmp_pd(j[0], n, _CMP_LT_OQ);
+
+        while (_mm256_movemask_pd(_mm256_or_pd(active[0], active[1]))) {
+            for (int v = 0; v < 2; ++v) {
+                b[v] = _mm256_blendv_pd(b[v], j[v], active[v]);
+                h[v] = _mm256_add_epi64(mullo64(h[v], mul), one);
+                const __m256d d = _mm256_add_pd(_mm256_sub_pd(_mm256_castsi256_pd(
+                    _mm256_or_si256(_mm256_srli_epi64(h[v], 33), magic)), magic_d), one_d);
+                const __m256d x = _mm256_mul_pd(_mm256_add_pd(b[v], one_d), _mm256_div_pd(two31, d));
+                j[v] = _mm256_blendv_pd(j[v], _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC),
+                    active[v]);
+                active[v] = _mm256_and_pd(active[v], _mm256_cmp_pd(j[v], n, _CMP_LT_OQ));
+            }
+        }
+
+        alignas(32) uint64_t buckets[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(buckets),
+            _mm256_castpd_si256(_mm256_add_pd(b[0], magic_d)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(buckets + 4),
+            _mm256_castpd_si256(_mm256_add_pd(b[1], magic_d)));
+        for (int l = 0; l < 8; ++l) {
+            out[l] = static_cast<uint32_t>(buckets[l]);
+        }
+    }
+#endif
+
     uint32_t m_num_buckets;
 };
 
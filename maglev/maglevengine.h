@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MAGLEVENGINE_H
+#define MAGLEVENGINE_H
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "../utils.h"
+
+/*
+ * Maglev hashing (D. E. Eisenbud et al., 2016).
+ *
+ * Every bucket has a permutation of the lookup table slots, given by an offset
+ * and a skip (the table size is prime, so every skip generates a permutation).
+ * The table is populated by letting the working buckets, in turn, claim the
+ * next free slot of their permutation. A lookup is one hash and one table
+ * access.
+ *
+ * The table is not rebuilt on resize: a removed bucket gives its slots to the
+ * remaining buckets in round-robin order, and an added bucket walks its
+ * permutation taking slots from the buckets that are above the new fair share.
+ * Only the keys of the removed bucket (or the keys moving to the new bucket)
+ * change bucket.
+ *
+ * When the working buckets have fewer than half of the permutations slots
+ * each, an added bucket rebuilds the table for the new working set, as in
+ * the paper: the balance is kept, but most of the keys move. The table has
+ * at most MAX_TABLE_SIZE slots.
+ */
+class MaglevEngine final {
+public:
+    /**
+     * Creates a new Maglev engine.
+     *
+     * The size of the lookup table is the smallest prime number greater
+     * than size * permutations, where permutations is read from the
+     * algorithm arguments (default 128).
+     *
+     * @param size initial number of working buckets (0 < size)
+     * @param args algorithm arguments
+     */
+    MaglevEngine(uint32_t, uint32_t size, const engine_arguments& args = {})
+    {
+        if (args.count("permutations")) {
+            m_permutations = std::max<uint64_t>(
+                str_to<uint64_t>(args.at("permutations"), DEFAULT_PERMUTATIONS), 1);
+        }
+        resizeTable(nextPrime(static_cast<uint64_t>(size) * m_permutations));
+
+        for (uint32_t b = 0; b < size; ++b) {
+            attach(b);
+        }
+        m_nextBucket = size;
+        populate();
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        const uint64_t hash = crc32c_sse42_u64(key, seed);
+        return m_table[(hash * m_tableSize) >> 32];
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   * The bucket takes slots, in its permutation order, from the buckets
+   * owning more than the fair share of the table.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket()
+    {
+        uint32_t bucket;
+        if (m_removed.empty()) {
+            bucket = m_nextBucket++;
+        }
+        else {
+            bucket = m_removed.back();
+            m_removed.pop_back();
+        }
+        attach(bucket);
+
+        if (m_working.size() == 1) {
+            populate();
+            return bucket;
+        }
+
+        const uint64_t wanted = m_working.size() * m_permutations;
+        if (m_tableSize < MAX_TABLE_SIZE
+            && (wanted > 2 * static_cast<uint64_t>(m_tableSize) || m_working.size() > m_tableSize)) {
+            rebuild(nextPrime(wanted));
+            return bucket;
+        }
+
+        const uint32_t share = m_tableSize / m_working.size();
+        uint32_t slot = m_next[bucket];
+        while (m_slots[bucket].size() < share) {
+            const uint32_t owner = m_table[slot];
+            if (m_slots[owner].size() > share) {
+                release(owner, slot);
+                assign(bucket, slot);
+            }
+            slot = advance(bucket, slot);
+        }
+        m_next[bucket] = slot;
+
+        return bucket;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   * The slots of the bucket are given to the remaining buckets in
+   * round-robin order.
+   *
+   * @param bucket the bucket to remove
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t bucket)
+    {
+        detach(bucket);
+        m_removed.push_back(bucket);
+        if (m_working.empty()) {
+            return bucket;
+        }
+
+        for (const uint32_t slot : m_slots[bucket]) {
+            if (m_cursor >= m_working.size()) {
+                m_cursor = 0;
+            }
+            assign(m_working[m_cursor++], slot);
+        }
+        m_slots[bucket].clear();
+
+        return bucket;
+    }
+
+    /**
+     * Returns the size of the working set.
+     *
+     * @return size of the working set.
+     */
+    uint32_t size() const noexcept { return m_working.size(); }
+
+    /**
+     * Returns the size of the lookup table.
+     *
+     * @return size of the lookup table.
+     */
+    uint32_t tableSize() const noexcept { return m_tableSize; }
+
+private:
+
+    static constexpr uint64_t DEFAULT_PERMUTATIONS = 128;
+
+    static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+    /* Largest prime below 2^32, so that slots and sizes fit in 32 bits */
+    static constexpr uint32_t MAX_TABLE_SIZE = 4294967291u;
+
+    // Smallest prime greater than x, up to MAX_TABLE_SIZE.
+    static uint32_t nextPrime(uint64_t x) noexcept
+    {
+        if (x >= MAX_TABLE_SIZE - 1) {
+            return MAX_TABLE_SIZE;
+        }
+        for (uint64_t candidate = x + 1;; ++candidate) {
+            bool prime = candidate >= 2;
+            for (uint64_t d = 2; d * d <= candidate && prime; ++d) {
+                prime = candidate % d != 0;
+            }
+            if (prime) {
+                return static_cast<uint32_t>(candidate);
+            }
+        }
+    }
+
+    static uint64_t mix(uint64_t x) noexcept
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Next slot in the permutation of the bucket.
+    uint32_t advance(uint32_t bucket, uint32_t slot) const noexcept
+    {
+        slot += m_skip[bucket];
+        return slot >= m_tableSize ? slot - m_tableSize : slot;
+    }
+
+    // Gives the slot to the bucket.
+    void assign(uint32_t bucket, uint32_t slot)
+    {
+        m_table[slot] = bucket;
+        m_slotIndex[slot] = m_slots[bucket].size();
+        m_slots[bucket].push_back(slot);
+    }
+
+    // Takes the slot away from its owner (the slot must be reassigned).
+    void release(uint32_t owner, uint32_t slot) noexcept
+    {
+        auto& slots = m_slots[owner];
+        const uint32_t last = slots.back();
+        slots[m_slotIndex[slot]] = last;
+        m_slotIndex[last] = m_slotIndex[slot];
+        slots.pop_back();
+    }
+
+    // Starts the permutation of the bucket over the current table.
+    void resetPermutation(uint32_t bucket) noexcept
+    {
+        m_next[bucket] = mix(bucket * 2 + 1) % m_tableSize;
+        m_skip[bucket] = mix(bucket * 2 + 2) % (m_tableSize - 1) + 1;
+    }
+
+    // Adds the bucket to the working list and resets its permutation.
+    void attach(uint32_t bucket)
+    {
+        if (bucket >= m_skip.size()) {
+            m_skip.resize(bucket + 1);
+            m_next.resize(bucket + 1);
+            m_slots.resize(bucket + 1);
+            m_index.resize(bucket + 1);
+        }
+        resetPermutation(bucket);
+        m_index[bucket] = m_working.size();
+        m_working.push_back(bucket);
+    }
+
+    // Removes the bucket from the working list.
+    void detach(uint32_t bucket) noexcept
+    {
+        const uint32_t last = m_working.back();
+        m_working[m_index[bucket]] = last;
+        m_index[last] = m_index[bucket];
+        m_working.pop_back();
+    }
+
+    void resizeTable(uint32_t table_size)
+    {
+        m_tableSize = table_size;
+        m_table.assign(m_tableSize, EMPTY);
+        m_slotIndex.assign(m_tableSize, 0);
+    }
+
+    // Builds a table of the given size for the working buckets, whose
+    // permutations depend on the table size.
+    void rebuild(uint32_t table_size)
+    {
+        resizeTable(table_size);
+        for (const uint32_t bucket : m_working) {
+            resetPermutation(bucket);
+        }
+        populate();
+    }
+
+    // Builds the whole lookup table as in the Maglev paper.
+    void populate()
+    {
+        std::fill(m_table.begin(), m_table.end(), EMPTY);
+        for (const uint32_t bucket : m_working) {
+            m_slots[bucket].clear();
+            m_slots[bucket].reserve(m_tableSize / m_working.size() + 1);
+        }
+        uint32_t filled = 0;
+        for (;;) {
+            for (const uint32_t bucket : m_working) {
+                uint32_t slot = m_next[bucket];
+                while (m_table[slot] != EMPTY) {
+                    slot = advance(bucket, slot);
+                }
+                assign(bucket, slot);
+                m_next[bucket] = advance(bucket, slot);
+                if (++filled == m_tableSize) {
+                    return;
+                }
+            }
+        }
+    }
+
+    /* The lookup table: slot -> bucket */
+    std::vector<uint32_t> m_table;
+    uint32_t m_tableSize;
+
+    /* Slots per working bucket the table is sized for */
+    uint64_t m_permutations = DEFAULT_PERMUTATIONS;
+
+    /* Working buckets and position of each bucket in m_working */
+    std::vector<uint32_t> m_working;
+    std::vector<uint32_t> m_index;
+
+    /* Per bucket: permutation skip and next slot of the permutation */
+    std::vector<uint32_t> m_skip;
+    std::vector<uint32_t> m_next;
+
+    /*
+     * Slots owned by each bucket and position of each slot in the list of
+     * its owner, so that a resize only touches the slots that move.
+     */
+    std::vector<std::vector<uint32_t>> m_slots;
+    std::vector<uint32_t> m_slotIndex;
+
+    /* Removed buckets, restored in LIFO order */
+    std::vector<uint32_t> m_removed;
+    uint32_t m_nextBucket;
+
+    /* Next heir for the slots of a removed bucket */
+    uint32_t m_cursor = 0;
+};
+
+#endif // MAGLEVENGINE_H
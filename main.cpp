@@ -42,6 +42,9 @@ int main(int argc, char* argv[]) {
                 commonSettings, distribution_function);
         }
         else if (current_benchmark.name == "resize-time") {
+            if (current_benchmark.args.count("grow-to")) {
+                csv_writer_handler.update_get_writer_called<MemoryUsage>(); // The growth scenario records the memory usage
+            }
             resize_time(csv_writer_handler.get_writer<ResizeTime>(),
                 commonSettings.outputFolder, current_benchmark, algorithms,
                 commonSettings);
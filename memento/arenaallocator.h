@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ARENAALLOCATOR_H
+#define ARENAALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+/*
+ * Allocator handing out single objects from contiguous slabs, for the
+ * entries of the chained tables (see MashTable). A released object goes to
+ * a free list and is handed out again before the current slab is used:
+ * once the table has reached its largest size, emplace and erase do not
+ * allocate any more. The slabs double from MIN_SLAB_SIZE to MAX_SLAB_SIZE
+ * objects and are only released with the allocator, so the memory follows
+ * the largest number of objects alive, not the current one.
+ *
+ * The allocator owns its slabs: it cannot be copied, and allocations of
+ * more than one object are forwarded to operator new.
+ */
+template <typename T> class ArenaAllocator final {
+
+  static constexpr std::size_t MIN_SLAB_SIZE = 1 << 5;
+  static constexpr std::size_t MAX_SLAB_SIZE = 1 << 16;
+
+  // A free object, or the header of a slab linking the previous one
+  union Node {
+    Node *m_next;
+    alignas(T) std::byte m_storage[sizeof(T)];
+  };
+
+  Node *m_slabs{nullptr};
+  Node *m_free{nullptr};
+  Node *m_current{nullptr};
+  Node *m_end{nullptr};
+  std::size_t m_slabSize{MIN_SLAB_SIZE};
+
+  void grow() {
+    auto slab{static_cast<Node *>(::operator new(sizeof(Node) * (m_slabSize + 1)))};
+    slab->m_next = m_slabs;
+    m_slabs = slab;
+    m_current = slab + 1;
+    m_end = m_current + m_slabSize;
+    m_slabSize = std::min(m_slabSize << 1, MAX_SLAB_SIZE);
+  }
+
+public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept = default;
+
+  ~ArenaAllocator() noexcept {
+    while (m_slabs) {
+      auto next{m_slabs->m_next};
+      ::operator delete(m_slabs);
+      m_slabs = next;
+    }
+  }
+
+  ArenaAllocator(const ArenaAllocator &) = delete;
+  ArenaAllocator &operator=(const ArenaAllocator &) = delete;
+
+  T *allocate(std::size_t n) {
+    if (n != 1) {
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    if (m_free) {
+      auto node{m_free};
+      m_free = node->m_next;
+      return reinterpret_cast<T *>(node);
+    }
+    if (m_current == m_end) {
+      grow();
+    }
+    return reinterpret_cast<T *>(m_current++);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (n != 1) {
+      ::operator delete(p);
+      return;
+    }
+    auto node{reinterpret_cast<Node *>(p)};
+    node->m_next = m_free;
+    m_free = node;
+  }
+};
+
+#endif // ARENAALLOCATOR_H
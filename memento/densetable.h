@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DENSETABLE_H
+#define DENSETABLE_H
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * Replacement set indexed directly by the key, for keys that are dense
+ * integers (the buckets of Memento are below bArraySize). The values are
+ * kept in a plain array and a bitset tells which keys are present, so that
+ * find is one bit test and one load. The arrays grow with the largest key
+ * ever stored and never shrink: the memory is proportional to the b-array,
+ * not to the number of removed buckets.
+ */
+template <std::integral K, typename V> class DenseTable final {
+
+  static constexpr uint32_t MIN_TABLE_SIZE = 1 << 6;
+
+  std::vector<V> m_values;
+  std::vector<uint64_t> m_present;
+  uint32_t m_size;
+
+  bool present(uint32_t index) const noexcept {
+    return m_present[index >> 6] >> (index & 63) & 1;
+  }
+
+  void resizeTable(uint32_t newTableSize) {
+    m_values.resize(newTableSize);
+    m_present.resize(newTableSize >> 6);
+  }
+
+public:
+  struct iterator final {
+    iterator() : m_pair{nullptr, V()} {}
+    iterator(const V *e) : m_pair{e, *e} {}
+    std::pair<const V *, V> m_pair;
+
+    const std::pair<const V *, V> &operator*() const noexcept { return m_pair; }
+    std::pair<const V *, V> *operator->() noexcept { return &m_pair; }
+    bool operator==(const iterator &o) const noexcept {
+      return m_pair.first == o.m_pair.first;
+    }
+    bool operator!=(const iterator &o) const noexcept {
+      return m_pair.first != o.m_pair.first;
+    }
+  };
+
+  DenseTable()
+      : m_values(MIN_TABLE_SIZE), m_present(MIN_TABLE_SIZE >> 6), m_size{0} {}
+
+  DenseTable(const DenseTable&) = delete;
+  DenseTable& operator=(const DenseTable&) = delete;
+
+  int emplace(const K &key, V &&value) {
+    const auto index{static_cast<uint32_t>(key)};
+    if (index >= m_values.size()) {
+      // Power of two sizes, a multiple of the 64 bits of a bitset word
+      resizeTable(std::max<uint32_t>(std::bit_ceil(index + 1), m_values.size() << 1));
+    }
+    else if (present(index)) {
+      // As the standard maps, the stored value stays
+      return key;
+    }
+    m_values[index] = std::move(value);
+    m_present[index >> 6] |= static_cast<uint64_t>(1) << (index & 63);
+    ++m_size;
+    return key;
+  }
+
+  bool empty() const noexcept { return m_size <= 0; }
+
+  uint32_t size() const noexcept { return m_size; }
+
+  iterator find(const K &key) const noexcept {
+    const auto index{static_cast<uint32_t>(key)};
+    if (index < m_values.size() && present(index)) {
+      return iterator{&m_values[index]};
+    }
+    return iterator{};
+  }
+
+  void erase(const iterator &it) {
+    if (it.m_pair.first) {
+      const auto index{static_cast<uint32_t>(it.m_pair.first - m_values.data())};
+      m_present[index >> 6] &= ~(static_cast<uint64_t>(1) << (index & 63));
+      --m_size;
+    }
+  }
+
+  const iterator &end() const {
+    static iterator e;
+    return e;
+  }
+};
+
+#endif // DENSETABLE_H
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FLATTABLE_H
+#define FLATTABLE_H
+
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Open addressing replacement set in the style of the Swiss tables: the keys
+ * and the values are stored inline in an array of slots (12 bytes for a
+ * bucket and a Memento entry), and a parallel array holds one control byte
+ * per slot: empty, deleted, or the 7 high bits of the hash of the key.
+ * The slots are probed by groups of 16: a single SSE2 comparison of the
+ * control bytes of a group finds the slots whose key may match, and the
+ * probe stops at the first group with an empty slot. A lookup touches one
+ * line of control bytes and, almost always, a single slot. There is no
+ * allocation per entry: the table doubles when it is 7/8 full, counting the
+ * deleted slots, and never shrinks.
+ */
+template <std::integral K, typename V> class FlatTable final {
+
+  static constexpr uint32_t GROUP_SIZE = 16;
+  static constexpr uint32_t MIN_GROUPS = 1;
+
+  static constexpr int8_t EMPTY = -128;   // 0b10000000
+  static constexpr int8_t DELETED = -2;   // 0b11111110
+
+  struct Slot final {
+    K m_key;
+    V m_value;
+  };
+
+  int8_t *m_control;
+  Slot *m_slots;
+  uint32_t m_groups;
+  uint32_t m_size;
+  uint32_t m_deleted;
+
+  static uint64_t hash(K key) noexcept {
+    return static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+  }
+
+  // Control byte of a full slot: the 7 high bits of the hash
+  static int8_t tag(uint64_t h) noexcept { return static_cast<int8_t>(h >> 57); }
+
+  // First group of the probe sequence, from the high half of the hash (the
+  // low bits of a multiplicative hash only depend on the low bits of the key)
+  uint32_t home(uint64_t h) const noexcept {
+    return static_cast<uint32_t>(h >> 32) & (m_groups - 1);
+  }
+
+  // Bit i is set when the control byte i of the group equals c
+  static uint32_t match(const int8_t *group, int8_t c) noexcept {
+#ifdef __SSE2__
+    const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < GROUP_SIZE; ++i) {
+      mask |= static_cast<uint32_t>(group[i] == c) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // Bit i is set when the slot i of the group is empty or deleted
+  static uint32_t matchFree(const int8_t *group) noexcept {
+#ifdef __SSE2__
+    const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return _mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < GROUP_SIZE; ++i) {
+      mask |= static_cast<uint32_t>(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // Slot of the key, or capacity() if it is not stored
+  uint32_t lookup(K key) const noexcept {
+    const auto h{hash(key)};
+    const auto t{tag(h)};
+    const uint32_t mask = m_groups - 1;
+    uint32_t g = home(h);
+    for (uint32_t step = 1;; ++step) {
+      const int8_t *group = m_control + g * GROUP_SIZE;
+      for (uint32_t m = match(group, t); m; m &= m - 1) {
+        const uint32_t slot = g * GROUP_SIZE + __builtin_ctz(m);
+        if (m_slots[slot].m_key == key) {
+          return slot;
+        }
+      }
+      if (match(group, EMPTY)) {
+        return capacity();
+      }
+      // Triangular probing visits every group of a power of two table
+      g = (g + step) & mask;
+    }
+  }
+
+  // First empty or deleted slot on the probe sequence of the hash
+  uint32_t freeSlot(uint64_t h) const noexcept {
+    const uint32_t mask = m_groups - 1;
+    uint32_t g = home(h);
+    for (uint32_t step = 1;; ++step) {
+      const uint32_t m = matchFree(m_control + g * GROUP_SIZE);
+      if (m) {
+        return g * GROUP_SIZE + __builtin_ctz(m);
+      }
+      g = (g + step) & mask;
+    }
+  }
+
+  void allocate(uint32_t groups) {
+    m_groups = groups;
+    m_control = new int8_t[groups * GROUP_SIZE];
+    std::memset(m_control, EMPTY, groups * GROUP_SIZE);
+    m_slots = new Slot[groups * GROUP_SIZE];
+  }
+
+  void resizeTable(uint32_t newGroups) {
+    auto control{m_control};
+    auto slots{m_slots};
+    const auto length{capacity()};
+    allocate(newGroups);
+    for (uint32_t i{0}; i < length; ++i) {
+      if (control[i] >= 0) {
+        const auto h{hash(slots[i].m_key)};
+        const auto slot{freeSlot(h)};
+        m_control[slot] = tag(h);
+        m_slots[slot] = std::move(slots[i]);
+      }
+    }
+    m_deleted = 0;
+    delete[] control;
+    delete[] slots;
+  }
+
+public:
+  struct iterator final {
+    iterator() : m_pair{nullptr, V()} {}
+    iterator(const Slot *e) : m_pair{e, e->m_value} {}
+    std::pair<const Slot *, V> m_pair;
+
+    const std::pair<const Slot *, V> &operator*() const noexcept { return m_pair; }
+    std::pair<const Slot *, V> *operator->() noexcept { return &m_pair; }
+    bool operator==(const iterator &o) const noexcept {
+      return m_pair.first == o.m_pair.first;
+    }
+    bool operator!=(const iterator &o) const noexcept {
+      return m_pair.first != o.m_pair.first;
+    }
+  };
+
+  FlatTable() : m_size{0}, m_deleted{0} { allocate(MIN_GROUPS); }
+
+  ~FlatTable() noexcept {
+    delete[] m_control;
+    delete[] m_slots;
+  }
+
+  FlatTable(const FlatTable&) = delete;
+  FlatTable& operator=(const FlatTable&) = delete;
+
+  int emplace(const K &key, V &&value) {
+    // As the standard maps, the stored value stays
+    if (lookup(key) != capacity()) {
+      return key;
+    }
+    if ((m_size + m_deleted + 1) * 8 > capacity() * 7) {
+      // Mostly deleted slots: rehash in place, otherwise grow
+      resizeTable(m_size * 2 < capacity() ? m_groups : m_groups << 1);
+    }
+    const auto h{hash(key)};
+    const auto slot{freeSlot(h)};
+    m_deleted -= m_control[slot] == DELETED;
+    m_control[slot] = tag(h);
+    m_slots[slot] = Slot{key, std::move(value)};
+    ++m_size;
+    return key;
+  }
+
+  bool empty() const noexcept { return m_size <= 0; }
+
+  uint32_t size() const noexcept { return m_size; }
+
+  uint32_t capacity() const noexcept { return m_groups * GROUP_SIZE; }
+
+  iterator find(const K &key) const noexcept {
+    const auto slot{lookup(key)};
+    if (slot != capacity()) {
+      return iterator{&m_slots[slot]};
+    }
+    return iterator{};
+  }
+
+  void erase(const iterator &it) {
+    if (it.m_pair.first) {
+      const auto slot{static_cast<uint32_t>(it.m_pair.first - m_slots)};
+      const int8_t *group = m_control + slot / GROUP_SIZE * GROUP_SIZE;
+      // The probes stop at a group with an empty slot: no tombstone needed
+      if (match(group, EMPTY)) {
+        m_control[slot] = EMPTY;
+      }
+      else {
+        m_control[slot] = DELETED;
+        ++m_deleted;
+      }
+      --m_size;
+    }
+  }
+
+  const iterator &end() const {
+    static iterator e;
+    return e;
+  }
+};
+
+#endif // FLATTABLE_H
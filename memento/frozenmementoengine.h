@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FROZENMEMENTOENGINE_H
+#define FROZENMEMENTOENGINE_H
+#include "../jump/jumpengine.h"
+#include "../utils.h"
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <xxhash.h>
+
+/*
+ * Immutable copy of a MementoEngine, built by MementoEngine::freeze() and
+ * only able to map keys (the results are the same as the engine it was
+ * built from).
+ *
+ * The replacement set is compiled into a minimal perfect hash of the removed
+ * buckets: a bitset over the b-array tells which buckets are removed and,
+ * with the number of removed buckets before each word of 64 bits stored
+ * next to the word, the rank of a removed bucket is its index in a compact
+ * array of replacers. Index 0 of the array holds -1 and the index is masked
+ * with the bit of the bucket, so that a lookup is one load of the word, a
+ * popcount and one load of the replacer, without branches and without
+ * probing, whether the bucket was removed or not.
+ */
+template <typename BaseHash = JumpEngine>
+class FrozenMementoEngine final {
+public:
+  /**
+   * Creates a new frozen MementoHash engine.
+   *
+   * @param bArraySize the size of the b-array
+   * @param replacer   returns the replacer of a bucket, -1 if it is working
+   */
+  template <typename Replacer>
+  FrozenMementoEngine(uint32_t bArraySize, Replacer &&replacer)
+      : m_blocks((bArraySize >> 6) + 1), m_replacers{-1},
+        m_bArraySize{bArraySize} {
+    for (uint32_t b = 0; b < bArraySize; ++b) {
+      auto &block = m_blocks[b >> 6];
+      if ((b & 63) == 0) {
+        // Index of the first replacer of the block, after the -1 at 0
+        block.rank = m_replacers.size();
+      }
+      const int32_t r = replacer(b);
+      if (r >= 0) {
+        block.removed |= static_cast<uint64_t>(1) << (b & 63);
+        m_replacers.push_back(r);
+      }
+    }
+    m_replacers.shrink_to_fit();
+  }
+
+  /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @return the related bucket
+   */
+  uint32_t getBucket(std::string_view key) const noexcept {
+    const auto hash{XXH64(key.data(), key.size(), 0)};
+    uint32_t b = BaseHash::bucketOf(hash, m_bArraySize);
+
+    /* Same walk as MementoEngine::getBucket. */
+    auto replacer = this->replacer(b);
+    while (replacer >= 0) {
+      const auto h = XXH64(key.data(), key.size(), b);
+      b = h % replacer;
+      auto r = this->replacer(b);
+      while (r >= replacer) {
+        b = r;
+        r = this->replacer(b);
+      }
+      replacer = r;
+    }
+
+    return b;
+  }
+
+  /**
+   * Returns the bucket where the given key should be mapped.
+   * This version uses the same hash function as Anchor
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+  uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept {
+    const auto hash = crc32c_sse42_u64(key, seed);
+    uint32_t b = BaseHash::bucketOf(hash, m_bArraySize);
+
+    /* Same walk as MementoEngine::getBucketCRC32c. */
+    auto replacer = this->replacer(b);
+    while (replacer >= 0) {
+      const auto h = crc32c_sse42_u64(key, b);
+      b = h % replacer;
+      auto r = this->replacer(b);
+      while (r >= replacer) {
+        b = r;
+        r = this->replacer(b);
+      }
+      replacer = r;
+    }
+
+    return b;
+  }
+
+  /**
+   * Returns the size of the working set.
+   *
+   * @return size of the working set.
+   */
+  uint32_t size() const noexcept {
+    return m_bArraySize - (m_replacers.size() - 1);
+  }
+
+  /**
+   * Returns the size of the b-array.
+   *
+   * @return the size of the b-array.
+   */
+  uint32_t bArraySize() const noexcept { return m_bArraySize; }
+
+private:
+  /* A word of the bitset and the index of its first replacer. */
+  struct Block final {
+    uint64_t removed{};
+    uint32_t rank{};
+  };
+
+  // Replacer of the bucket (b < bArraySize), -1 if it was not removed.
+  int32_t replacer(uint32_t b) const noexcept {
+    const auto &block = m_blocks[b >> 6];
+    const uint64_t below = (static_cast<uint64_t>(1) << (b & 63)) - 1;
+    const uint32_t index = block.rank + std::popcount(block.removed & below);
+    const uint32_t present = -static_cast<uint32_t>(block.removed >> (b & 63) & 1);
+    return m_replacers[index & present];
+  }
+
+  std::vector<Block> m_blocks;
+  std::vector<int32_t> m_replacers;
+  uint32_t m_bArraySize;
+};
+
+#endif // FROZENMEMENTOENGINE_H
@@ -16,16 +16,39 @@
 #ifndef MASHTABLE_H
 #define MASHTABLE_H
 
+#include "arenaallocator.h"
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <utility>
 
 template<class T>
 concept Integral = std::is_integral<T>::value;
 
-template <Integral K, typename V> class MashTable final {
+/*
+ * With Incremental, a resize does not touch the whole table at once. The new
+ * bucket array is allocated without being initialised, and every emplace or
+ * erase clears CLEAR_STEP of its buckets while the current table stays in
+ * use. Once it is cleared, the previous table is kept and every emplace or
+ * erase moves the chains of MIGRATION_STEP of its buckets to the new one,
+ * while find looks in both. A table doubles after at least 3/4 of its length
+ * of emplaces and halves after at least 3/32 of it of erasures, so clearing
+ * and migration are always over before the next resize and no operation
+ * writes more than a few buckets.
+ *
+ * Allocator is the allocator of the entries: with ArenaAllocator, they come
+ * from contiguous slabs and erased entries are reused, so that the table
+ * stops allocating once it has reached its largest size.
+ */
+template <Integral K, typename V, bool Incremental = false,
+          template <typename> class Allocator = std::allocator>
+class BasicMashTable final {
 
   static constexpr uint32_t MIN_TABLE_SIZE = 1 << 4;
   static constexpr uint32_t MAX_TABLE_SIZE = 1 << 30;
+  static constexpr uint32_t MIGRATION_STEP = 16;
+  // One page of bucket pointers, so that an operation faults in one page.
+  static constexpr uint32_t CLEAR_STEP = 512;
 
   struct Item final {
     K m_key;
@@ -36,10 +59,32 @@ template <Integral K, typename V> class MashTable final {
         : m_key{key}, m_value{value}, m_next{next} {}
   };
 
+  Allocator<Item> m_items;
   Item **m_table;
   uint32_t m_length;
   uint32_t m_size;
 
+  // Previous table during an incremental resize: its buckets in
+  // [m_migrated, m_oldLength) are not moved yet.
+  Item **m_old;
+  uint32_t m_oldLength;
+  uint32_t m_migrated;
+
+  // Next table during an incremental resize, before it is in use: its
+  // buckets in [m_cleared, m_pendingLength) are not initialised yet.
+  Item **m_pending;
+  uint32_t m_pendingLength;
+  uint32_t m_cleared;
+
+  Item *newItem(K key, V &&value) {
+    return new (m_items.allocate(1)) Item{key, std::move(value)};
+  }
+
+  void deleteItem(Item *entry) noexcept {
+    entry->~Item();
+    m_items.deallocate(entry, 1);
+  }
+
   void add(Item *entry, Item **table, uint32_t table_length) {
     auto kint{static_cast<unsigned int>(entry->m_key)};
     unsigned int hash = kint ^ kint >> 16;
@@ -53,6 +98,16 @@ template <Integral K, typename V> class MashTable final {
       return;
     if (newTableSize > m_length && m_length >= MAX_TABLE_SIZE)
       return;
+    if constexpr (Incremental) {
+      if (m_pending) {
+        return;
+      }
+      migrate(m_oldLength);
+      m_pending = new Item *[newTableSize];
+      m_pendingLength = newTableSize;
+      m_cleared = 0;
+      return;
+    }
     auto newTable{new Item *[newTableSize]()};
     for (unsigned int i{0}; i < m_length; ++i) {
       auto entry{m_table[i]};
@@ -70,11 +125,78 @@ template <Integral K, typename V> class MashTable final {
 
   uint32_t capacity() const noexcept { return (m_length >> 2) * 3; }
 
+  // Clears the next buckets of the next table, or moves the chains of the
+  // next buckets of the previous table once the next table is in use.
+  void step() {
+    if (!m_pending) {
+      migrate(MIGRATION_STEP);
+      return;
+    }
+    const auto count{std::min(CLEAR_STEP, m_pendingLength - m_cleared)};
+    std::fill_n(m_pending + m_cleared, count, nullptr);
+    m_cleared += count;
+    if (m_cleared == m_pendingLength) {
+      m_old = m_table;
+      m_oldLength = m_length;
+      m_migrated = 0;
+      m_length = m_pendingLength;
+      m_table = m_pending;
+      m_pending = nullptr;
+      m_pendingLength = 0;
+    }
+  }
+
+  // Moves the chains of the next count buckets of the previous table.
+  void migrate(uint32_t count) {
+    if (!m_old) {
+      return;
+    }
+    for (; count && m_migrated < m_oldLength; --count, ++m_migrated) {
+      auto entry{m_old[m_migrated]};
+      while (entry) {
+        auto next = entry->m_next;
+        entry->m_next = nullptr;
+        add(entry, m_table, m_length);
+        entry = next;
+      }
+      m_old[m_migrated] = nullptr;
+    }
+    if (m_migrated == m_oldLength) {
+      delete[] m_old;
+      m_old = nullptr;
+      m_oldLength = 0;
+    }
+  }
+
+  static Item *search(const K &key, Item **table, uint32_t table_length) {
+    auto kint{static_cast<unsigned int>(key)};
+    int hash = kint ^ kint >> 16;
+    int index = (table_length - 1) & hash;
+    auto entry{table[index]};
+    while (entry) {
+      if (entry->m_key == key) {
+        return entry;
+      }
+      entry = entry->m_next;
+    }
+    return nullptr;
+  }
+
   void remove(const K &key) {
+    if constexpr (Incremental) {
+      if (m_old && !search(key, m_table, m_length)) {
+        remove(key, m_old, m_oldLength);
+        return;
+      }
+    }
+    remove(key, m_table, m_length);
+  }
+
+  void remove(const K &key, Item **table, uint32_t table_length) {
     auto kint{static_cast<unsigned int>(key)};
     int hash = kint ^ kint >> 16;
-    int index = (m_length - 1) & hash;
-    auto entry{m_table[index]};
+    int index = (table_length - 1) & hash;
+    auto entry{table[index]};
     if (!entry) {
       return;
     }
@@ -89,11 +211,11 @@ template <Integral K, typename V> class MashTable final {
     }
 
     if (prev == nullptr) {
-      m_table[index] = entry->m_next;
+      table[index] = entry->m_next;
     } else {
       prev->m_next = entry->m_next;
     }
-    delete entry;
+    deleteItem(entry);
   }
 
   void doFree(Item** t, uint32_t s) {
@@ -101,7 +223,7 @@ template <Integral K, typename V> class MashTable final {
           auto e{t[i]};
           while(e) {
               auto next{e->m_next};
-              delete e;
+              deleteItem(e);
               e = next;
           }
       }
@@ -124,19 +246,27 @@ public:
     }
   };
 
-  MashTable()
+  BasicMashTable()
       : m_table{new Item *[MIN_TABLE_SIZE]()}, m_length{MIN_TABLE_SIZE},
-        m_size{0} {}
+        m_size{0}, m_old{nullptr}, m_oldLength{0}, m_migrated{0},
+        m_pending{nullptr}, m_pendingLength{0}, m_cleared{0} {}
 
-  ~MashTable() noexcept {
+  ~BasicMashTable() noexcept {
       doFree(m_table,m_length);
+      if (m_old) {
+          doFree(m_old, m_oldLength);
+      }
+      delete[] m_pending;
   }
 
-  MashTable(const MashTable&) = delete;
-  MashTable& operator=(const MashTable&) = delete;
+  BasicMashTable(const BasicMashTable&) = delete;
+  BasicMashTable& operator=(const BasicMashTable&) = delete;
 
   int emplace(const K &key, V &&value) noexcept {
-    Item *entry{new Item{key, std::move(value)}};
+    if constexpr (Incremental) {
+      step();
+    }
+    Item *entry{newItem(key, std::move(value))};
     add(entry, m_table, m_length);
     ++m_size;
     if (m_size > capacity()) {
@@ -160,10 +290,22 @@ public:
       }
       entry = entry->m_next;
     }
+    if constexpr (Incremental) {
+      // Not moved yet
+      if (m_old) {
+        entry = search(key, m_old, m_oldLength);
+        if (entry) {
+          return iterator{entry};
+        }
+      }
+    }
     return iterator{};
   }
 
   void erase(const iterator &it) {
+    if constexpr (Incremental) {
+      step();
+    }
     if (it.m_pair.first) {
           remove(it.m_pair.first->m_key);
       --m_size;
@@ -178,4 +320,13 @@ public:
   }
 };
 
+template <typename K, typename V>
+using MashTable = BasicMashTable<K, V, false>;
+
+template <typename K, typename V>
+using IncrementalMashTable = BasicMashTable<K, V, true>;
+
+template <typename K, typename V>
+using ArenaMashTable = BasicMashTable<K, V, false, ArenaAllocator>;
+
 #endif // MASHTABLE_H
@@ -16,11 +16,20 @@
 #ifndef MEMENTOENGINE_H
 #define MEMENTOENGINE_H
 #include "memento.h"
+#include "frozenmementoengine.h"
+#include "../jump/jumpengine.h"
 #include "../utils.h"
 #include <string_view>
 #include <xxhash.h>
 
-template <template <typename...> class MementoMap, typename... Args>
+/*
+ * MementoMap is the map storing the replacements of the removed buckets.
+ * BaseHash is the consistent hash used to map keys onto the b-array: any
+ * engine providing a static bucketOf(hash, size) mapping a hash to
+ * [0, size-1] (Jump by default, or a constant-time one like Power, Binomial
+ * or FlipHash).
+ */
+template <template <typename...> class MementoMap, typename BaseHash = JumpEngine>
 class MementoEngine final {
 public:
   /**
@@ -40,10 +49,10 @@ public:
   uint32_t getBucket(std::string_view key) const noexcept {
     const auto hash{XXH64(key.data(), key.size(), 0)};
     /*
-     * We invoke JumpHash to get a bucket
-     * in the range [0,bArraySize-1].
+     * We invoke the base hash (JumpHash by default)
+     * to get a bucket in the range [0,bArraySize-1].
      */
-    auto b = JumpConsistentHash(hash, m_bArraySize);
+    uint32_t b = BaseHash::bucketOf(hash, m_bArraySize);
 
     /*
      * We check if the bucket was removed, if not we are done.
@@ -92,10 +101,10 @@ public:
   uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept {
     const auto hash = crc32c_sse42_u64(key, seed);
     /*
-     * We invoke JumpHash to get a bucket
-     * in the range [0,bArraySize-1].
+     * We invoke the base hash (JumpHash by default)
+     * to get a bucket in the range [0,bArraySize-1].
      */
-    auto b = JumpConsistentHash(hash, m_bArraySize);
+    uint32_t b = BaseHash::bucketOf(hash, m_bArraySize);
 
     /*
      * We check if the bucket was removed, if not we are done.
@@ -195,19 +204,22 @@ public:
    */
   uint32_t bArraySize() const noexcept { return m_bArraySize; }
 
-private:
-
-  // From Jump paper
-  static int32_t JumpConsistentHash(uint64_t key, int32_t num_buckets) {
-    int64_t b = 1, j = 0;
-    while (j < num_buckets) {
-      b = j;
-      key = key * 2862933555777941757ULL + 1;
-      j = (b + 1) * (double(1LL << 31) / double((key >> 33) + 1));
-    }
-    return b;
+  /**
+   * Returns an immutable copy of the engine that can only map keys,
+   * to be used when the cluster is not expected to change for a while.
+   * The replacement set is compiled into a structure without probing
+   * (see FrozenMementoEngine), which takes time linear in the size
+   * of the b-array.
+   *
+   * @return the frozen engine.
+   */
+  FrozenMementoEngine<BaseHash> freeze() const {
+    return FrozenMementoEngine<BaseHash>(m_bArraySize,
+        [this](uint32_t bucket) { return m_memento.replacer(bucket); });
   }
 
+private:
+
   Memento<MementoMap> m_memento;
   uint32_t m_bArraySize;
   uint32_t m_lastRemoved;
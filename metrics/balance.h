@@ -27,17 +27,31 @@
 #endif
 #include "../anchor/anchorengine.h"
 #include "../memento/mashtable.h"
+#include "../memento/densetable.h"
+#include "../memento/flattable.h"
 #include "../memento/mementoengine.h"
 #include "../jump/jumpengine.h"
+#include "../jump/jumpbackengine.h"
+#include "../jump/jump64engine.h"
+#include "../binomial/binomialengine.h"
+#include "../fliphash/fliphashengine.h"
+#include "../maglev/maglevengine.h"
+#include "../ring/ringengine.h"
+#include "../multiprobe/multiprobeengine.h"
+#include "../rendezvous/rendezvousengine.h"
 #include "../power/powerengine.h"
+#include "../power/powerFastEngine.h"
+#include "../power/power64engine.h"
 #include <fmt/core.h>
 #include <fstream>
 #include <unordered_map>
 #include <gtl/phmap.hpp>
 #include "../dx/dxEngine.h"
+#include "../dx/dxFastEngine.h"
 #include "../CsvWriter/csvWriter.h"
 #include "../utils.h"
 #include "../YamlParser/YamlParser.h"
+#include <algorithm>
 #include <vector>
 
  /*
@@ -48,59 +62,35 @@
 template <typename Algorithm, typename T>
 inline void bench(const std::string& name,
     std::size_t anchor_set /* capacity */, std::size_t working_set,
-    uint32_t num_keys, std::size_t iterations, Balance& balance,
-    random_distribution_ptr<T> random_fnt) {
+    std::size_t num_keys, std::size_t iterations, Balance& balance,
+    random_distribution_ptr<T> random_fnt, const engine_arguments& algorithm_args = {}) {
 
-    Algorithm engine(anchor_set, working_set);
+    auto engine = make_engine<Algorithm>(anchor_set, working_set, algorithm_args);
 
-    // For each given iteration, we want to store the total number of keys for each node
-    // since we need to find out which nodes have the min/max number of keys for each iteration,
-    // and thus calculate the average for both min and max.
-    std::vector<std::vector<uint32_t>> keys_per_node(iterations, std::vector<uint32_t>(working_set));
+    // For each given iteration, we count the keys of each node to find out which nodes
+    // have the min/max number of keys, and thus calculate the average for both min and max.
+    // The keys are drawn while they are mapped: with 10^7 nodes and hundreds of keys
+    // per node, the sequence of keys would not fit in memory.
+    std::vector<uint32_t> keys_per_node(working_set);
+    double max_sum = 0.;
+    double min_sum = 0.;
 
     for (std::size_t current_iteration = 0; current_iteration < iterations; ++current_iteration) {
-        const auto random_keys = generate_random_keys_sequence(num_keys, random_fnt);
-
-        for (const auto& current_random_key : random_keys) {
-            const auto a = current_random_key.first;
-            const auto b = current_random_key.second;
+        std::fill(keys_per_node.begin(), keys_per_node.end(), 0);
+        for (std::size_t i = 0; i < num_keys; ++i) {
+            const auto a = (*random_fnt)();
+            const auto b = (*random_fnt)();
             const auto target_node = engine.getBucketCRC32c(a, b);
-
-            // Keep track of the number of keys for each node, for all iterations.
-            keys_per_node[current_iteration][target_node]++;
-        }
-    }
-
-    // Finds the max or min value (depending on the compare functor passed) in a given vector.
-    // In our case, the vector represents the nodes and their respective number of stored keys.
-    auto find_maxmin = [](const std::vector<uint32_t>& vec, std::function<bool(uint32_t, uint32_t)> compare) {
-        std::size_t maxmin = vec[0];
-        for (const auto& val : vec) {
-            if (compare(val, maxmin)) {
-                maxmin = val;
-            }
-        }
-        return maxmin;
-        };
-
-    // Calculates the average value given a vector of nodes containing K keys.
-    auto calculate_average = [](const std::vector<uint32_t>& vec) {
-        double avg = 0.;
-        for (const auto& value : vec) {
-            avg += value;
+            keys_per_node[target_node]++;
         }
-        return avg / vec.size();
-        };
 
-    std::vector<uint32_t> max_values_per_iteration(iterations);
-    std::vector<uint32_t> min_values_per_iteration(iterations);
-    for (std::size_t idx = 0; idx < iterations; ++idx) {
-        max_values_per_iteration[idx] = find_maxmin(keys_per_node[idx], std::greater<uint32_t>());
-        min_values_per_iteration[idx] = find_maxmin(keys_per_node[idx], std::less<uint32_t>());
+        const auto [min, max] = std::minmax_element(keys_per_node.begin(), keys_per_node.end());
+        min_sum += *min;
+        max_sum += *max;
     }
 
-    balance.max = calculate_average(max_values_per_iteration);
-    balance.min = calculate_average(min_values_per_iteration);
+    balance.max = max_sum / iterations;
+    balance.min = min_sum / iterations;
     balance.max_percentage = balance.max * working_set / num_keys;
     balance.min_percentage = balance.min * working_set / num_keys;
     balance.expected = num_keys / working_set;
@@ -112,9 +102,12 @@ inline void balance(CsvWriter<Balance>& balance_writer,
     const std::vector<AlgorithmSettings>& algorithms, std::size_t iterations,
     const std::unordered_map<std::string, random_distribution_ptr<T>>& distribution_function) {
     
-    uint32_t key_multiplier = 100;
-    if (current_benchmark.args.count("keyMultiplier")) {
-        key_multiplier = str_to<uint32_t>(current_benchmark.args.at("keyMultiplier"), 100);
+    // Number of keys per node, keys-per-node being the same as keyMultiplier
+    std::size_t key_multiplier = 100;
+    if (current_benchmark.args.count("keys-per-node")) {
+        key_multiplier = str_to<std::size_t>(current_benchmark.args.at("keys-per-node"), 100);
+    } else if (current_benchmark.args.count("keyMultiplier")) {
+        key_multiplier = str_to<std::size_t>(current_benchmark.args.at("keyMultiplier"), 100);
     }
         
     for (const auto& hash_function : current_benchmark.commonSettings.hashFunctions) { // Done for all benchmarks
@@ -144,7 +137,13 @@ inline void balance(CsvWriter<Balance>& balance_writer,
 
                     if (current_algorithm.name == "anchor") {
                         bench<AnchorEngine>("Anchor", capacity, working_set,
-                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "anchor-fastmod") {
+                        bench<AnchorFastModEngine>("AnchorFastMod", capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
                     }
                     else if (current_algorithm.name == "memento") {
                         bench<MementoEngine<boost::unordered_flat_map>>(
@@ -171,6 +170,41 @@ inline void balance(CsvWriter<Balance>& balance_writer,
                             capacity, working_set,
                             key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
                     }
+                    else if (current_algorithm.name == "mementomash-incremental") {
+                        bench<MementoEngine<IncrementalMashTable>>("Memento<IncrementalMashTable>",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "mementomash-arena") {
+                        bench<MementoEngine<ArenaMashTable>>("Memento<ArenaMashTable>",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "mementodense") {
+                        bench<MementoEngine<DenseTable>>("Memento<DenseTable>",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "mementoflat") {
+                        bench<MementoEngine<FlatTable>>("Memento<FlatTable>",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "memento-power") {
+                        bench<MementoEngine<boost::unordered_flat_map, PowerEngine>>(
+                            "Memento<boost::unordered_flat_map, PowerEngine>", capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "memento-binomial") {
+                        bench<MementoEngine<boost::unordered_flat_map, BinomialEngine>>(
+                            "Memento<boost::unordered_flat_map, BinomialEngine>", capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "memento-fliphash") {
+                        bench<MementoEngine<boost::unordered_flat_map, FlipHashEngine>>(
+                            "Memento<boost::unordered_flat_map, FlipHashEngine>", capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
                     else if (current_algorithm.name == "jump") {
                         bench<JumpEngine>("JumpEngine",
                             capacity, working_set,
@@ -181,8 +215,67 @@ inline void balance(CsvWriter<Balance>& balance_writer,
                             capacity, working_set,
                             key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
                     }
+                    else if (current_algorithm.name == "jumpback") {
+                        bench<JumpBackEngine>("JumpBackEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "binomial") {
+                        bench<BinomialEngine>("BinomialEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "maglev") {
+                        bench<MaglevEngine>("MaglevEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "ring") {
+                        bench<RingEngine>("RingEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "multiprobe") {
+                        bench<MultiProbeEngine>("MultiProbeEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "rendezvous") {
+                        bench<RendezvousEngine>("RendezvousEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "fliphash") {
+                        bench<FlipHashEngine>("FlipHashEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "power-fast") {
+                        bench<PowerFastEngine>("PowerFastEngine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "jump64") {
+                        bench<Jump64Engine>("Jump64Engine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
+                    else if (current_algorithm.name == "power64") {
+                        bench<Power64Engine>("Power64Engine",
+                            capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
+                    }
                     else if (current_algorithm.name == "dx") {
                         bench<DxEngine>("DxPower", capacity, working_set,
+                            key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "dx-fast") {
+                        bench<DxFastEngine>("DxFastEngine", capacity, working_set,
                             key_multiplier * working_set, iterations, balance, random_gen_fnt_ptr);
                     }
                     else {
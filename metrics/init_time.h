@@ -22,10 +22,23 @@
 #include <chrono>
 #include "../anchor/anchorengine.h"
 #include "../memento/mashtable.h"
+#include "../memento/densetable.h"
+#include "../memento/flattable.h"
 #include "../memento/mementoengine.h"
 #include "../jump/jumpengine.h"
+#include "../jump/jumpbackengine.h"
+#include "../jump/jump64engine.h"
+#include "../binomial/binomialengine.h"
+#include "../fliphash/fliphashengine.h"
+#include "../maglev/maglevengine.h"
+#include "../ring/ringengine.h"
+#include "../multiprobe/multiprobeengine.h"
+#include "../rendezvous/rendezvousengine.h"
 #include "../power/powerengine.h"
+#include "../power/powerFastEngine.h"
+#include "../power/power64engine.h"
 #include "../dx/dxEngine.h"
+#include "../dx/dxFastEngine.h"
 #include "../YamlParser/YamlParser.h"
 #include "../CsvWriter/csvWriter.h"
 #include <boost/unordered/unordered_flat_map.hpp>
@@ -46,7 +59,7 @@ template <typename Algorithm>
 inline void bench(const std::string& name,
     std::size_t anchor_set /* capacity */, std::size_t working_set,
     uint32_t total_iterations, uint32_t total_seconds, InitTime& init_time,
-    const std::string& time_unit) {
+    const std::string& time_unit, const engine_arguments& algorithm_args = {}) {
 
     std::vector<double> results;
 
@@ -58,7 +71,7 @@ inline void bench(const std::string& name,
         && std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time).count() < total_seconds; ++i) {
 
         const auto start_bench = std::chrono::steady_clock::now();
-        Algorithm engine(anchor_set, working_set);
+        auto engine = make_engine<Algorithm>(anchor_set, working_set, algorithm_args);
         const auto end_bench = std::chrono::steady_clock::now();
 
         // prevent optimization
@@ -98,64 +111,173 @@ inline void init_time(CsvWriter<InitTime>& init_time_writer,
     const uint32_t total_seconds = common_settings.secondsForEachIteration;
     const std::string time_unit = common_settings.unit;
 
+    // Optional sweep over the capacity, given as multiples of the working set
+    // (e.g. capacity-factors: [10, 100, 1000]): it overrides the capacity
+    // argument of the algorithms.
+    std::vector<double> capacity_factors;
+    if (current_benchmark.args.count("capacity-factors")) {
+        capacity_factors = parse_fractions(current_benchmark.args.at("capacity-factors"));
+    }
+
     for (const auto& hash_function : current_benchmark.commonSettings.hashFunctions) {
         for (const auto& current_algorithm : algorithms) {
             for (const auto& working_set : current_benchmark.commonSettings.numInitialActiveNodes) {
 
-                InitTime init_time("init_time => bench", common_settings.mode, 1, total_iterations,
-                    common_settings.unit, current_algorithm.name, hash_function, working_set);
-
-                uint32_t capacity = working_set * 10; // default = 10
-                if (current_algorithm.args.count("capacity")) {
-                    capacity = str_to<uint32_t>(current_algorithm.args.at("capacity"), 10) * working_set;
-                }
-
-                if (current_algorithm.name == "anchor") {
-                    bench<AnchorEngine>("Anchor", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "memento") {
-                    bench<MementoEngine<boost::unordered_flat_map>>(
-                        "Memento<boost::unordered_flat_map>", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "mementoboost") {
-                    bench<MementoEngine<boost::unordered_map>>(
-                        "Memento<boost::unordered_map>", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "mementostd") {
-                    bench<MementoEngine<std::unordered_map>>(
-                        "Memento<std::unordered_map>", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "mementogtl") {
-                    bench<MementoEngine<gtl::flat_hash_map>>(
-                        "Memento<std::gtl::flat_hash_map>", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
+                std::vector<uint32_t> capacities;
+                for (double factor : capacity_factors) {
+                    capacities.push_back(static_cast<uint32_t>(factor * working_set));
                 }
-                else if (current_algorithm.name == "mementomash") {
-                    bench<MementoEngine<MashTable>>("Memento<MashTable>",
-                        capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "jump") {
-                    bench<JumpEngine>("JumpEngine", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "power") {
-                    bench<PowerEngine>("PowerEngine", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else if (current_algorithm.name == "dx") {
-                    bench<DxEngine>("DxEngine", capacity, working_set,
-                        total_iterations, total_seconds, init_time, time_unit);
-                }
-                else {
-                    fmt::println("[ResizeTime] Unknown algorithm {}", current_algorithm.name);
+                if (capacities.empty()) {
+                    uint32_t capacity = working_set * 10; // default = 10
+                    if (current_algorithm.args.count("capacity")) {
+                        capacity = str_to<uint32_t>(current_algorithm.args.at("capacity"), 10) * working_set;
+                    }
+                    capacities.push_back(capacity);
                 }
 
-                init_time_writer.add(init_time);
+                for (const uint32_t capacity : capacities) {
+                    InitTime init_time("init_time => bench", common_settings.mode, 1, total_iterations,
+                        common_settings.unit, current_algorithm.name, hash_function, working_set);
+                    init_time.param_capacity = capacity;
+
+                    if (current_algorithm.name == "anchor") {
+                        bench<AnchorEngine>("Anchor", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "anchor-fastmod") {
+                        bench<AnchorFastModEngine>("AnchorFastMod", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "memento") {
+                        bench<MementoEngine<boost::unordered_flat_map>>(
+                            "Memento<boost::unordered_flat_map>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementoboost") {
+                        bench<MementoEngine<boost::unordered_map>>(
+                            "Memento<boost::unordered_map>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementostd") {
+                        bench<MementoEngine<std::unordered_map>>(
+                            "Memento<std::unordered_map>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementogtl") {
+                        bench<MementoEngine<gtl::flat_hash_map>>(
+                            "Memento<std::gtl::flat_hash_map>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementomash") {
+                        bench<MementoEngine<MashTable>>("Memento<MashTable>",
+                            capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementomash-incremental") {
+                        bench<MementoEngine<IncrementalMashTable>>("Memento<IncrementalMashTable>",
+                            capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementomash-arena") {
+                        bench<MementoEngine<ArenaMashTable>>("Memento<ArenaMashTable>",
+                            capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementodense") {
+                        bench<MementoEngine<DenseTable>>("Memento<DenseTable>",
+                            capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "mementoflat") {
+                        bench<MementoEngine<FlatTable>>("Memento<FlatTable>",
+                            capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "memento-power") {
+                        bench<MementoEngine<boost::unordered_flat_map, PowerEngine>>(
+                            "Memento<boost::unordered_flat_map, PowerEngine>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "memento-binomial") {
+                        bench<MementoEngine<boost::unordered_flat_map, BinomialEngine>>(
+                            "Memento<boost::unordered_flat_map, BinomialEngine>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "memento-fliphash") {
+                        bench<MementoEngine<boost::unordered_flat_map, FlipHashEngine>>(
+                            "Memento<boost::unordered_flat_map, FlipHashEngine>", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "jump") {
+                        bench<JumpEngine>("JumpEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "power") {
+                        bench<PowerEngine>("PowerEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "jumpback") {
+                        bench<JumpBackEngine>("JumpBackEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "binomial") {
+                        bench<BinomialEngine>("BinomialEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "maglev") {
+                        bench<MaglevEngine>("MaglevEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "ring") {
+                        bench<RingEngine>("RingEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "multiprobe") {
+                        bench<MultiProbeEngine>("MultiProbeEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "rendezvous") {
+                        bench<RendezvousEngine>("RendezvousEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "fliphash") {
+                        bench<FlipHashEngine>("FlipHashEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "power-fast") {
+                        bench<PowerFastEngine>("PowerFastEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "jump64") {
+                        bench<Jump64Engine>("Jump64Engine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "power64") {
+                        bench<Power64Engine>("Power64Engine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else if (current_algorithm.name == "dx") {
+                        bench<DxEngine>("DxEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit,
+                            current_algorithm.args);
+                    }
+                    else if (current_algorithm.name == "dx-fast") {
+                        bench<DxFastEngine>("DxFastEngine", capacity, working_set,
+                            total_iterations, total_seconds, init_time, time_unit);
+                    }
+                    else {
+                        fmt::println("[ResizeTime] Unknown algorithm {}", current_algorithm.name);
+                    }
+
+
+                    init_time_writer.add(init_time);
+                }
             }
         }
     }
@@ -22,10 +22,23 @@
 #include <chrono>
 #include "../anchor/anchorengine.h"
 #include "../memento/mashtable.h"
+#include "../memento/densetable.h"
+#include "../memento/flattable.h"
 #include "../memento/mementoengine.h"
 #include "../jump/jumpengine.h"
+#include "../jump/jumpbackengine.h"
+#include "../jump/jump64engine.h"
+#include "../binomial/binomialengine.h"
+#include "../fliphash/fliphashengine.h"
+#include "../maglev/maglevengine.h"
+#include "../ring/ringengine.h"
+#include "../multiprobe/multiprobeengine.h"
+#include "../rendezvous/rendezvousengine.h"
 #include "../power/powerengine.h"
+#include "../power/powerFastEngine.h"
+#include "../power/power64engine.h"
 #include "../dx/dxEngine.h"
+#include "../dx/dxFastEngine.h"
 #include "../YamlParser/YamlParser.h"
 #include "../CsvWriter/csvWriter.h"
 #ifdef USE_PCG32
@@ -42,6 +55,9 @@
 #include "../utils.h"
 #include <string_view>
 #include <limits>
+#include <span>
+#include <cstdlib>
+#include <malloc.h>
 
 
  /*
@@ -58,31 +74,66 @@ static unsigned long allocated{ 0 };
 static unsigned long deallocated{ 0 };
 static unsigned long maximum{ 0 };
 
-inline void* operator new(size_t size) {
-    void* p = malloc(size);
+// Bytes of the blocks alive, as seen by malloc: the maximum is its peak.
+// Arrays of trivial types are released by the unsized operator delete[],
+// which does not know the requested size.
+static unsigned long live{ 0 };
+
+inline void count_allocation(void* p, std::size_t size) noexcept {
     allocations += 1;
     allocated += size;
-    maximum = allocated > maximum ? allocated : maximum;
+    live += malloc_usable_size(p);
+    maximum = live > maximum ? live : maximum;
+}
+
+inline void count_deallocation(void* ptr, std::size_t size) noexcept {
+    deallocations += 1;
+    deallocated += size;
+    live -= malloc_usable_size(ptr);
+}
+
+inline void* operator new(size_t size) {
+    void* p = malloc(size);
+    count_allocation(p, size);
     return p;
 }
 
 inline void* operator new[](size_t size) {
     void* p = malloc(size);
-    allocations += 1;
-    allocated += size;
-    maximum = allocated > maximum ? allocated : maximum;
+    count_allocation(p, size);
     return p;
 }
 
 inline void operator delete(void* ptr, std::size_t size) noexcept {
-    deallocations += 1;
-    deallocated += size;
+    count_deallocation(ptr, size);
     free(ptr);
 }
 
 inline void operator delete[](void* ptr, std::size_t size) noexcept {
-    deallocations += 1;
-    deallocated += size;
+    count_deallocation(ptr, size);
+    free(ptr);
+}
+
+inline void operator delete(void* ptr) noexcept {
+    if (ptr) count_deallocation(ptr, malloc_usable_size(ptr));
+    free(ptr);
+}
+
+inline void operator delete[](void* ptr) noexcept {
+    if (ptr) count_deallocation(ptr, malloc_usable_size(ptr));
+    free(ptr);
+}
+
+// Cache-aligned containers (see aligned_allocator) are measured as well.
+inline void* operator new(size_t size, std::align_val_t alignment) {
+    const auto align = static_cast<size_t>(alignment);
+    void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+    count_allocation(p, size);
+    return p;
+}
+
+inline void operator delete(void* ptr, std::size_t size, std::align_val_t) noexcept {
+    count_deallocation(ptr, size);
     free(ptr);
 }
 
@@ -91,6 +142,7 @@ inline void reset_memory_stats() noexcept {
     allocated = 0;
     deallocations = 0;
     deallocated = 0;
+    live = 0;
     maximum = 0;
 }
 
@@ -113,6 +165,133 @@ inline void print_memory_stats(std::string_view label) noexcept {
     maximum = memory_usage.maximum;
 }
 
+/*
+* ******************************************
+* Batch throughput routine
+* ******************************************
+*/
+// Measures how many keys per second the engine maps through the scalar lookup
+// and through the batched one (getBucketsCRC32c). Both results are added to the
+// LookupTime csv as "Throughput" rows, next to the average lookup time.
+template <typename Algorithm, typename T>
+inline void batch_bench(Algorithm& engine, uint32_t batch_size,
+    uint32_t total_iterations, uint32_t total_seconds,
+    const LookupTime& lookup_time, random_distribution_ptr<T> random_fnt) {
+
+    std::vector<uint64_t> keys(batch_size);
+    for (auto& key : keys) {
+        key = (*random_fnt)();
+    }
+    const uint64_t seed = (*random_fnt)();
+    std::vector<uint32_t> buckets(batch_size);
+    volatile uint32_t checksum = 0;
+
+    auto measure = [&](const std::string& label, auto&& lookup) {
+        std::vector<double> results;
+        const auto start_time = std::chrono::steady_clock::now();
+        auto current_time = start_time;
+        for (std::size_t i = 0; i < total_iterations
+            && std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time).count() < total_seconds; ++i) {
+            const auto start_bench = std::chrono::steady_clock::now();
+            lookup();
+            const auto end_bench = std::chrono::steady_clock::now();
+            checksum = checksum + buckets[i % batch_size];
+
+            const double elapsed_seconds = convert_elapsed_time_to(end_bench, start_bench, "SECONDS");
+            results.push_back(batch_size / elapsed_seconds);
+
+            current_time = std::chrono::steady_clock::now();
+        }
+
+        // For an explanation, see bench below.
+        LookupTime throughput{ lookup_time };
+        throughput.benchmark = "speed_test => batch_bench";
+        throughput.mode = "Throughput";
+        throughput.unit = "keys/s";
+        throughput.param_benchmark = label;
+
+        double total = 0.;
+        for (double result : results) {
+            total += result;
+        }
+        // No batch is measured when the time limit is 0
+        throughput.score = results.empty() ? std::numeric_limits<double>::quiet_NaN() : total / results.size();
+        double sum_squared_diff = 0.0;
+        for (double result : results) {
+            const double diff = result - throughput.score;
+            sum_squared_diff += diff * diff;
+        }
+        if (results.size() > 1) {
+            const double variance = sum_squared_diff / (results.size() - 1);
+            throughput.score_error = sqrt(variance) / sqrt(results.size());
+        }
+        else {
+            throughput.score_error = std::numeric_limits<double>::quiet_NaN();
+        }
+
+        fmt::println("[LookupTime] {}: {:.0f} keys/s over batches of {} keys", label, throughput.score, batch_size);
+        CsvWriter<LookupTime>::getInstance().add(throughput);
+    };
+
+    measure("lookuptime-scalar", [&] {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            buckets[i] = engine.getBucketCRC32c(keys[i], seed);
+        }
+    });
+    measure("lookuptime-batch", [&] {
+        engine.getBucketsCRC32c(keys, seed, buckets);
+    });
+}
+
+/*
+* ******************************************
+* Lookup routine
+* ******************************************
+*/
+// Times total_iterations lookups of random keys (or as many as fit in
+// total_seconds) and returns the time of each one.
+template <typename Algorithm, typename T>
+inline std::vector<double> lookups(Algorithm& engine,
+    uint32_t total_iterations, uint32_t total_seconds,
+    const LookupTime& lookup_time, random_distribution_ptr<T> random_fnt,
+    const std::string& time_unit, uint32_t batch_size) {
+
+    // Lazy initialization of the specified random function
+    // First call is slower because the random number generator must be initialized, we want to avoid that
+    volatile uint32_t lazy_init = (*random_fnt)();
+
+    std::vector<double> results;
+    volatile uint32_t bucket = 0;
+
+    // We keep track of both:
+    //  - how many seconds the bench should last at max (time.execution)
+    //  - how many iterations the benchmark should be repeated (time.execution)
+    // The first condition to be satisfied ends the benchmark.
+    const auto start_time = std::chrono::steady_clock::now();
+    auto current_time = start_time;
+    for (std::size_t i = 0; i < total_iterations
+        && std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time).count() < total_seconds; ++i) {
+        const auto start_bench = std::chrono::steady_clock::now();
+        bucket = engine.getBucketCRC32c((*random_fnt)(), (*random_fnt)());
+        const auto end_bench = std::chrono::steady_clock::now();
+
+        double elapsed_time_value = convert_elapsed_time_to(end_bench, start_bench, time_unit);
+        results.push_back(elapsed_time_value);
+
+        current_time = std::chrono::steady_clock::now();
+    }
+    print_memory_stats("EndBenchmark");
+
+    if constexpr (requires(std::span<const uint64_t> k, std::span<uint32_t> o) {
+        engine.getBucketsCRC32c(k, uint64_t{}, o); }) {
+        if (batch_size) {
+            batch_bench(engine, batch_size, total_iterations, total_seconds, lookup_time, random_fnt);
+        }
+    }
+
+    return results;
+}
+
 /*
 * ******************************************
 * Benchmark routine
@@ -123,7 +302,30 @@ inline void bench(const std::string& name,
     std::size_t anchor_set /* capacity */, std::size_t working_set,
     uint32_t num_removals, uint32_t total_iterations, uint32_t total_seconds, 
     LookupTime& lookup_time, random_distribution_ptr<T> random_fnt,
-    const std::string& removal_order, const std::string& time_unit) {
+    const std::string& removal_order, const std::string& time_unit,
+    uint32_t batch_size, const engine_arguments& algorithm_args = {}) {
+
+    // With frozen: "true", the lookups run on the immutable copy returned by
+    // freeze() (e.g. Memento), built once the removals are done.
+    bool frozen = algorithm_args.count("frozen") && algorithm_args.at("frozen") == "true";
+    if (frozen) {
+        if constexpr (requires(const Algorithm& e) { e.freeze(); }) {
+            lookup_time.param_algorithm += "-frozen";
+            memory_usage.algorithm += "-frozen";
+        }
+        else {
+            fmt::println("[LookupTime] {} cannot be frozen, ignoring frozen: true", name);
+            frozen = false;
+        }
+    }
+
+    // Bounded probing (e.g. Dx with max-probes) is a different mapping of the keys.
+    if constexpr (requires(const Algorithm& e) { e.maxProbes(); }) {
+        if (algorithm_args.count("max-probes") && algorithm_args.at("max-probes") != "0") {
+            lookup_time.param_algorithm += "-k" + algorithm_args.at("max-probes");
+            memory_usage.algorithm += "-k" + algorithm_args.at("max-probes");
+        }
+    }
 
     uint32_t* nodes = new uint32_t[anchor_set]();
     for (uint32_t i = 0; i < working_set; ++i) {
@@ -132,7 +334,7 @@ inline void bench(const std::string& name,
 
     reset_memory_stats();
     print_memory_stats("StartBenchmark");
-    Algorithm engine(anchor_set, working_set);
+    auto engine = make_engine<Algorithm>(anchor_set, working_set, algorithm_args);
     print_memory_stats("AfterAlgorithmInit");
 
     if (num_removals) {
@@ -159,31 +361,19 @@ inline void bench(const std::string& name,
     }
     print_memory_stats("AfterRemovals");
 
-    // Lazy initialization of the specified random function
-    // First call is slower because the random number generator must be initialized, we want to avoid that
-    volatile uint32_t lazy_init = (*random_fnt)();
-
     std::vector<double> results;
-    volatile uint32_t bucket = 0;
-
-    // We keep track of both:
-    //  - how many seconds the bench should last at max (time.execution)
-    //  - how many iterations the benchmark should be repeated (time.execution)
-    // The first condition to be satisfied ends the benchmark.
-    const auto start_time = std::chrono::steady_clock::now();
-    auto current_time = start_time;
-    for (std::size_t i = 0; i < total_iterations
-        && std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time).count() < total_seconds; ++i) {
-        const auto start_bench = std::chrono::steady_clock::now();
-        bucket = engine.getBucketCRC32c((*random_fnt)(), (*random_fnt)());
-        const auto end_bench = std::chrono::steady_clock::now();
-
-        double elapsed_time_value = convert_elapsed_time_to(end_bench, start_bench, time_unit);
-        results.push_back(elapsed_time_value);
-
-        current_time = std::chrono::steady_clock::now();
+    if constexpr (requires { engine.freeze(); }) {
+        if (frozen) {
+            const auto snapshot = engine.freeze();
+            print_memory_stats("AfterFreeze");
+            results = lookups(snapshot, total_iterations, total_seconds,
+                lookup_time, random_fnt, time_unit, batch_size);
+        }
+    }
+    if (!frozen) {
+        results = lookups(engine, total_iterations, total_seconds,
+            lookup_time, random_fnt, time_unit, batch_size);
     }
-    print_memory_stats("EndBenchmark");
 
     // We need to find the total elapsed time to find the average elapsed time
     // which is lookup_time.score.
@@ -211,6 +401,17 @@ inline void bench(const std::string& name,
         lookup_time.score_error = std::numeric_limits<double>::quiet_NaN();
     }
 
+    // The tail of the distribution (e.g. engines probing a random number of
+    // times): 99th and 99.9th percentiles.
+    if (!results.empty()) {
+        const std::size_t p99 = (results.size() * 99 + 99) / 100 - 1;
+        const std::size_t p999 = (results.size() * 999 + 999) / 1000 - 1;
+        std::nth_element(results.begin(), results.begin() + p99, results.end());
+        lookup_time.score_p99 = results[p99];
+        std::nth_element(results.begin() + p99, results.begin() + p999, results.end());
+        lookup_time.score_p999 = results[p999];
+    }
+
     delete[] nodes;
 }
         
@@ -242,6 +443,21 @@ inline void speed_test(CsvWriter<LookupTime>& lookuptime_writer,
         removal_order = "lifo";
     }
 
+    // Further parse "batch-size": when set, engines with a batched lookup also
+    // report keys/second for the scalar and the batched path. Default = 0 (disabled).
+    uint32_t batch_size{};
+    if (current_benchmark.args.count("batch-size")) {
+        batch_size = str_to<uint32_t>(current_benchmark.args.at("batch-size"), 0);
+    }
+
+    // Optional sweep over the capacity, as in init-time (e.g.
+    // capacity-factors: [2, 10, 100]): it overrides the capacity argument
+    // of the algorithms.
+    std::vector<double> capacity_factors;
+    if (current_benchmark.args.count("capacity-factors")) {
+        capacity_factors = parse_fractions(current_benchmark.args.at("capacity-factors"));
+    }
+
     const uint32_t total_iterations = common_settings.totalBenchmarkIterations; 
     const uint32_t total_seconds = common_settings.secondsForEachIteration;
     const std::string time_unit = common_settings.unit;
@@ -252,92 +468,248 @@ inline void speed_test(CsvWriter<LookupTime>& lookuptime_writer,
             for (const auto& key_distribution : current_benchmark.commonSettings.keyDistributions) { 
                 for (const auto& working_set : current_benchmark.commonSettings.numInitialActiveNodes) {
             
-                    LookupTime lookup_time("speed_test => bench", common_settings.mode, 1, total_iterations,
-                        common_settings.unit, current_algorithm.name, "lookuptime",
-                        key_distribution, hash_function, working_set);
-
-                    memory_usage.algorithm = current_algorithm.name;
-                    memory_usage.nodes = working_set;
-                    memory_usage.hash_function = hash_function;
-                    
-                    random_distribution_ptr<T> random_gen_fnt_ptr;
-                    if (distribution_function.count(key_distribution)) {
-                        random_gen_fnt_ptr = distribution_function.at(key_distribution);
+                    std::vector<uint32_t> capacities;
+                    for (double factor : capacity_factors) {
+                        capacities.push_back(static_cast<uint32_t>(factor * working_set));
                     }
-                    else {
-                        fmt::println("[LookupTime] The specified distribution is not available. Proceeding with default UNIFORM");
-                        random_gen_fnt_ptr = distribution_function.at("uniform");
+                    if (capacities.empty()) {
+                        uint32_t capacity = working_set * 10; // default = 10
+                        if (current_algorithm.args.count("capacity")) {
+                            capacity = str_to<uint32_t>(current_algorithm.args.at("capacity"), 10) * working_set;
+                        }
+                        capacities.push_back(capacity);
                     }
 
-                    uint32_t capacity = working_set * 10; // default = 10
-                    if (current_algorithm.args.count("capacity")) {
-                        capacity = str_to<uint32_t>(current_algorithm.args.at("capacity"), 10) * working_set;
-                    }
+                    for (const uint32_t capacity : capacities) {
+                        LookupTime lookup_time("speed_test => bench", common_settings.mode, 1, total_iterations,
+                            common_settings.unit, current_algorithm.name, "lookuptime",
+                            key_distribution, hash_function, working_set);
+                        lookup_time.param_capacity = capacity;
 
-                    const uint32_t num_removals = static_cast<uint32_t>(removal_rate * working_set);
-
-                    if (current_algorithm.name == "anchor") {
-                        bench<AnchorEngine>("Anchor", capacity, working_set,
-                            num_removals, total_iterations, total_seconds, 
-                            lookup_time, random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "memento") {
-                        bench<MementoEngine<boost::unordered_flat_map>>(
-                            "Memento<boost::unordered_flat_map>", capacity, working_set,
-                            num_removals, total_iterations, total_seconds,
-                            lookup_time, random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "mementoboost") {
-                        bench<MementoEngine<boost::unordered_map>>(
-                            "Memento<boost::unordered_map>", capacity, working_set,
-                            num_removals, total_iterations, total_seconds,
-                            lookup_time, random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "mementostd") {
-                        bench<MementoEngine<std::unordered_map>>(
-                            "Memento<std::unordered_map>", capacity, working_set,
-                            num_removals, total_iterations, total_seconds,
-                            lookup_time, random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "mementogtl") {
-                        bench<MementoEngine<gtl::flat_hash_map>>(
-                            "Memento<std::gtl::flat_hash_map>", capacity, working_set,
-                            num_removals, total_iterations, 
-                            total_seconds, lookup_time,
-                            random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "mementomash") {
-                        bench<MementoEngine<MashTable>>("Memento<MashTable>",
-                            capacity, working_set,
-                            num_removals, total_iterations, 
-                            total_seconds, lookup_time,
-                            random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "jump") {
-                        bench<JumpEngine>("JumpEngine",
-                            capacity, working_set,
-                            num_removals, total_iterations,
-                            total_seconds, lookup_time,
-                            random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "power") {
-                        bench<PowerEngine>("PowerEngine",
-                            capacity, working_set,
-                            num_removals, total_iterations, 
-                            total_seconds, lookup_time,
-                            random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else if (current_algorithm.name == "dx") {
-                        bench<DxEngine>("DxEngine", capacity, working_set,
-                            num_removals, total_iterations, 
-                            total_seconds, lookup_time,
-                            random_gen_fnt_ptr, removal_order, time_unit);
-                    }
-                    else {
-                        fmt::println("[LookupTime] Unknown algorithm {}", current_algorithm.name);
+                        memory_usage.algorithm = current_algorithm.name;
+                        memory_usage.nodes = working_set;
+                        memory_usage.hash_function = hash_function;
+                    
+                        random_distribution_ptr<T> random_gen_fnt_ptr;
+                        if (distribution_function.count(key_distribution)) {
+                            random_gen_fnt_ptr = distribution_function.at(key_distribution);
+                        }
+                        else {
+                            fmt::println("[LookupTime] The specified distribution is not available. Proceeding with default UNIFORM");
+                            random_gen_fnt_ptr = distribution_function.at("uniform");
+                        }
+
+                        const uint32_t num_removals = static_cast<uint32_t>(removal_rate * working_set);
+
+                        if (current_algorithm.name == "anchor") {
+                            bench<AnchorEngine>("Anchor", capacity, working_set,
+                                num_removals, total_iterations, total_seconds, 
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "anchor-fastmod") {
+                            bench<AnchorFastModEngine>("AnchorFastMod", capacity, working_set,
+                                num_removals, total_iterations, total_seconds, 
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "memento") {
+                            bench<MementoEngine<boost::unordered_flat_map>>(
+                                "Memento<boost::unordered_flat_map>", capacity, working_set,
+                                num_removals, total_iterations, total_seconds,
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementoboost") {
+                            bench<MementoEngine<boost::unordered_map>>(
+                                "Memento<boost::unordered_map>", capacity, working_set,
+                                num_removals, total_iterations, total_seconds,
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementostd") {
+                            bench<MementoEngine<std::unordered_map>>(
+                                "Memento<std::unordered_map>", capacity, working_set,
+                                num_removals, total_iterations, total_seconds,
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementogtl") {
+                            bench<MementoEngine<gtl::flat_hash_map>>(
+                                "Memento<std::gtl::flat_hash_map>", capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementomash") {
+                            bench<MementoEngine<MashTable>>("Memento<MashTable>",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementomash-incremental") {
+                            bench<MementoEngine<IncrementalMashTable>>("Memento<IncrementalMashTable>",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementomash-arena") {
+                            bench<MementoEngine<ArenaMashTable>>("Memento<ArenaMashTable>",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementodense") {
+                            bench<MementoEngine<DenseTable>>("Memento<DenseTable>",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "mementoflat") {
+                            bench<MementoEngine<FlatTable>>("Memento<FlatTable>",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "memento-power") {
+                            bench<MementoEngine<boost::unordered_flat_map, PowerEngine>>(
+                                "Memento<boost::unordered_flat_map, PowerEngine>", capacity, working_set,
+                                num_removals, total_iterations, total_seconds,
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "memento-binomial") {
+                            bench<MementoEngine<boost::unordered_flat_map, BinomialEngine>>(
+                                "Memento<boost::unordered_flat_map, BinomialEngine>", capacity, working_set,
+                                num_removals, total_iterations, total_seconds,
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "memento-fliphash") {
+                            bench<MementoEngine<boost::unordered_flat_map, FlipHashEngine>>(
+                                "Memento<boost::unordered_flat_map, FlipHashEngine>", capacity, working_set,
+                                num_removals, total_iterations, total_seconds,
+                                lookup_time, random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "jump") {
+                            bench<JumpEngine>("JumpEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "power") {
+                            bench<PowerEngine>("PowerEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "jumpback") {
+                            bench<JumpBackEngine>("JumpBackEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "binomial") {
+                            bench<BinomialEngine>("BinomialEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "maglev") {
+                            bench<MaglevEngine>("MaglevEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "ring") {
+                            bench<RingEngine>("RingEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "multiprobe") {
+                            bench<MultiProbeEngine>("MultiProbeEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "rendezvous") {
+                            bench<RendezvousEngine>("RendezvousEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "fliphash") {
+                            bench<FlipHashEngine>("FlipHashEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "power-fast") {
+                            bench<PowerFastEngine>("PowerFastEngine",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "jump64") {
+                            bench<Jump64Engine>("Jump64Engine",
+                                capacity, working_set,
+                                num_removals, total_iterations,
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "power64") {
+                            bench<Power64Engine>("Power64Engine",
+                                capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else if (current_algorithm.name == "dx") {
+                            bench<DxEngine>("DxEngine", capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "dx-fast") {
+                            bench<DxFastEngine>("DxFastEngine", capacity, working_set,
+                                num_removals, total_iterations, 
+                                total_seconds, lookup_time,
+                                random_gen_fnt_ptr, removal_order, time_unit, batch_size);
+                        }
+                        else {
+                            fmt::println("[LookupTime] Unknown algorithm {}", current_algorithm.name);
+                        }
+
+                        lookuptime_writer.add(lookup_time);
                     }
-
-                    lookuptime_writer.add(lookup_time);
                 }
             }
         }
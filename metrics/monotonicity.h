@@ -32,9 +32,21 @@
 #include <sstream>
 #include "../anchor/anchorengine.h"
 #include "../jump/jumpengine.h"
+#include "../jump/jumpbackengine.h"
+#include "../jump/jump64engine.h"
+#include "../binomial/binomialengine.h"
+#include "../fliphash/fliphashengine.h"
+#include "../maglev/maglevengine.h"
+#include "../ring/ringengine.h"
+#include "../multiprobe/multiprobeengine.h"
+#include "../rendezvous/rendezvousengine.h"
 #include "../memento/mashtable.h"
+#include "../memento/densetable.h"
+#include "../memento/flattable.h"
 #include "../memento/mementoengine.h"
 #include "../power/powerengine.h"
+#include "../power/powerFastEngine.h"
+#include "../power/power64engine.h"
 #include <fmt/core.h>
 #include <fstream>
 #include <string>
@@ -42,6 +54,7 @@
 #include <unordered_map>
 #include <vector>
 #include "../dx/dxEngine.h"
+#include "../dx/dxFastEngine.h"
 #include "../YamlParser/YamlParser.h"
 #include "../CsvWriter/csvWriter.h"
 #include "../utils.h"
@@ -83,14 +96,15 @@ template <typename Algorithm, typename T>
 inline void bench(const std::string& name,
     std::size_t anchor_set, std::size_t working_set,
     uint32_t num_removals, uint32_t num_keys, double current_fraction,
-    Monotonicity& monotonicity, random_distribution_ptr<T> random_fnt) {
+    Monotonicity& monotonicity, random_distribution_ptr<T> random_fnt,
+    const engine_arguments& algorithm_args = {}) {
 
     auto bench_results = initialize_bench_results(working_set,
         { "keys_per_node", "moved_from_removed_nodes",
         "moved_from_other_nodes", "moved_to_restored_nodes",
         "moved_to_other_nodes", "relocated_after_resize"});
 
-    Algorithm engine(anchor_set, working_set);
+    auto engine = make_engine<Algorithm>(anchor_set, working_set, algorithm_args);
 
     // anchor_set = total nodes, not necessarily all used now
     uint32_t* nodes = new uint32_t[anchor_set]();
@@ -319,7 +333,14 @@ inline void monotonicity(CsvWriter<Monotonicity>& monotonicity_writer,
                         if (current_algorithm.name == "anchor") {
                             bench<AnchorEngine>("Anchor", capacity, working_set,
                                 num_removals, key_multiplier * working_set, current_fraction,
-                                monotonicity, random_gen_fnt_ptr);
+                                monotonicity, random_gen_fnt_ptr,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "anchor-fastmod") {
+                            bench<AnchorFastModEngine>("AnchorFastMod", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr,
+                                current_algorithm.args);
                         }
                         else if (current_algorithm.name == "memento") {
                             bench<MementoEngine<boost::unordered_flat_map>>(
@@ -351,6 +372,48 @@ inline void monotonicity(CsvWriter<Monotonicity>& monotonicity_writer,
                                 num_removals, key_multiplier * working_set, current_fraction,
                                 monotonicity, random_gen_fnt_ptr);
                         }
+                        else if (current_algorithm.name == "mementomash-incremental") {
+                            bench<MementoEngine<IncrementalMashTable>>("Memento<IncrementalMashTable>",
+                                capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "mementomash-arena") {
+                            bench<MementoEngine<ArenaMashTable>>("Memento<ArenaMashTable>",
+                                capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "mementodense") {
+                            bench<MementoEngine<DenseTable>>("Memento<DenseTable>",
+                                capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "mementoflat") {
+                            bench<MementoEngine<FlatTable>>("Memento<FlatTable>",
+                                capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "memento-power") {
+                            bench<MementoEngine<boost::unordered_flat_map, PowerEngine>>(
+                                "Memento<boost::unordered_flat_map, PowerEngine>", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "memento-binomial") {
+                            bench<MementoEngine<boost::unordered_flat_map, BinomialEngine>>(
+                                "Memento<boost::unordered_flat_map, BinomialEngine>", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "memento-fliphash") {
+                            bench<MementoEngine<boost::unordered_flat_map, FlipHashEngine>>(
+                                "Memento<boost::unordered_flat_map, FlipHashEngine>", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
                         else if (current_algorithm.name == "jump") {
                             bench<JumpEngine>("JumpEngine", capacity, working_set,
                                 num_removals, key_multiplier * working_set, current_fraction,
@@ -361,8 +424,67 @@ inline void monotonicity(CsvWriter<Monotonicity>& monotonicity_writer,
                                 num_removals, key_multiplier * working_set, current_fraction,
                                 monotonicity, random_gen_fnt_ptr);
                         }
+                        else if (current_algorithm.name == "jumpback") {
+                            bench<JumpBackEngine>("JumpBackEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "binomial") {
+                            bench<BinomialEngine>("BinomialEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "maglev") {
+                            bench<MaglevEngine>("MaglevEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "ring") {
+                            bench<RingEngine>("RingEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "multiprobe") {
+                            bench<MultiProbeEngine>("MultiProbeEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "rendezvous") {
+                            bench<RendezvousEngine>("RendezvousEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr,
+                                current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "fliphash") {
+                            bench<FlipHashEngine>("FlipHashEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "power-fast") {
+                            bench<PowerFastEngine>("PowerFastEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "jump64") {
+                            bench<Jump64Engine>("Jump64Engine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
+                        else if (current_algorithm.name == "power64") {
+                            bench<Power64Engine>("Power64Engine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr);
+                        }
                         else if (current_algorithm.name == "dx") {
                             bench<DxEngine>("DxEngine", capacity, working_set,
+                                num_removals, key_multiplier * working_set, current_fraction,
+                                monotonicity, random_gen_fnt_ptr, current_algorithm.args);
+                        }
+                        else if (current_algorithm.name == "dx-fast") {
+                            bench<DxFastEngine>("DxFastEngine", capacity, working_set,
                                 num_removals, key_multiplier * working_set, current_fraction,
                                 monotonicity, random_gen_fnt_ptr);
                         }
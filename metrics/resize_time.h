@@ -22,12 +22,26 @@
 #include <chrono>
 #include "../anchor/anchorengine.h"
 #include "../memento/mashtable.h"
+#include "../memento/densetable.h"
+#include "../memento/flattable.h"
 #include "../memento/mementoengine.h"
 #include "../jump/jumpengine.h"
+#include "../jump/jumpbackengine.h"
+#include "../jump/jump64engine.h"
+#include "../binomial/binomialengine.h"
+#include "../fliphash/fliphashengine.h"
+#include "../maglev/maglevengine.h"
+#include "../ring/ringengine.h"
+#include "../multiprobe/multiprobeengine.h"
+#include "../rendezvous/rendezvousengine.h"
 #include "../power/powerengine.h"
+#include "../power/powerFastEngine.h"
+#include "../power/power64engine.h"
 #include "../dx/dxEngine.h"
+#include "../dx/dxFastEngine.h"
 #include "../YamlParser/YamlParser.h"
 #include "../CsvWriter/csvWriter.h"
+#include "lookup_time.h"
 #ifdef USE_PCG32
 #include "pcg_random.hpp"
 #include <random>
@@ -42,6 +56,89 @@
 #include "../utils.h"
 #include <string_view>
 #include <limits>
+#include <numeric>
+#include <random>
+
+/*
+* ******************************************
+* Growth routine
+* ******************************************
+*/
+// Grows the cluster from the working set to grow_to buckets, one decade at a
+// time (e.g. 100, 1000, ..., 10^6). Each step adds a ResizeTime row with the
+// time taken by its addBucket calls and a MemoryUsage row whose maximum is
+// the peak of the live heap during the step; resize_time gets the whole
+// growth.
+template <typename Algorithm>
+inline void grow(Algorithm& engine, std::size_t working_set, uint32_t grow_to,
+    ResizeTime& resize_time, const std::string& time_unit) {
+
+    fmt::println("[ResizeTime] Growing from {} to {} nodes", working_set, grow_to);
+    memory_usage.nodes = working_set;
+    print_memory_stats("AfterAlgorithmInit");
+
+    double total_elapsed_time = 0.;
+    for (std::size_t nodes = working_set; nodes < grow_to;) {
+        const std::size_t start = nodes;
+        const std::size_t target = std::min<std::size_t>(std::max<std::size_t>(nodes * 10, nodes + 1), grow_to);
+
+        maximum = live;
+        const auto start_bench = std::chrono::steady_clock::now();
+        for (; nodes < target; ++nodes) {
+            engine.addBucket();
+        }
+        const auto end_bench = std::chrono::steady_clock::now();
+
+        ResizeTime step = resize_time;
+        step.benchmark = fmt::format("resize_time => grow to {}", target);
+        step.param_init_nodes = start;
+        step.score = convert_elapsed_time_to(end_bench, start_bench, time_unit);
+        step.score_error = std::numeric_limits<double>::quiet_NaN();
+        CsvWriter<ResizeTime>::getInstance().add(step);
+        print_memory_stats(fmt::format("AfterGrowTo{}", target));
+        fmt::println("[ResizeTime] Grown to {} nodes in {} {}", target, step.score, time_unit);
+
+        total_elapsed_time += step.score;
+    }
+
+    resize_time.benchmark = "resize_time => grow";
+    resize_time.score = total_elapsed_time;
+    resize_time.score_error = std::numeric_limits<double>::quiet_NaN();
+}
+
+/*
+* ******************************************
+* Removal storm routine
+* ******************************************
+*/
+// Removes storm_rate * working_set random buckets, then adds them back, one
+// at a time: every operation is timed on its own so that the rare expensive
+// ones (e.g. a rehash of the replacement set) show up in the maximum and in
+// the 99.9th percentile.
+template <typename Algorithm>
+inline void storm(Algorithm& engine, std::size_t working_set, double storm_rate,
+    std::vector<double>& results, const std::string& time_unit) {
+
+    std::vector<uint32_t> buckets(working_set);
+    std::iota(buckets.begin(), buckets.end(), 0);
+    std::shuffle(buckets.begin(), buckets.end(), std::mt19937{42});
+    const std::size_t removals = static_cast<std::size_t>(storm_rate * working_set);
+
+    fmt::println("[ResizeTime] Removing and restoring {} nodes", removals);
+    results.reserve(2 * removals);
+    for (std::size_t i = 0; i < removals; ++i) {
+        const auto start_bench = std::chrono::steady_clock::now();
+        engine.removeBucket(buckets[i]);
+        const auto end_bench = std::chrono::steady_clock::now();
+        results.push_back(convert_elapsed_time_to(end_bench, start_bench, time_unit));
+    }
+    for (std::size_t i = 0; i < removals; ++i) {
+        const auto start_bench = std::chrono::steady_clock::now();
+        engine.addBucket();
+        const auto end_bench = std::chrono::steady_clock::now();
+        results.push_back(convert_elapsed_time_to(end_bench, start_bench, time_unit));
+    }
+}
 
 /*
 * ******************************************
@@ -52,32 +149,48 @@ template <typename Algorithm>
 inline void bench(const std::string& name,
     std::size_t anchor_set /* capacity */, std::size_t working_set,
     uint32_t total_iterations, uint32_t total_seconds, ResizeTime& resize_time, 
-    const std::string& time_unit) {
+    const std::string& time_unit, uint32_t grow_to, double storm_rate,
+    const engine_arguments& algorithm_args = {}) {
+
+    if (grow_to) {
+        reset_memory_stats();
+    }
+    auto engine = make_engine<Algorithm>(anchor_set, working_set, algorithm_args);
 
-    Algorithm engine(anchor_set, working_set);
+    if (grow_to) {
+        grow(engine, working_set, grow_to, resize_time, time_unit);
+        return;
+    }
 
     std::vector<double> results;
 
-    fmt::println("[ResizeTime] Starting benchmark, num iterations: {}", total_iterations);
-    // We keep track of both:
-    //  - how many seconds the bench should last at max (time.execution)
-    //  - how many iterations the benchmark should be repeated (time.execution)
-    // The first condition to be satisfied ends the benchmark.
-    const auto start_time = std::chrono::steady_clock::now();
-    auto current_time = start_time;
-    for (std::size_t i = 0; i < total_iterations
-        && std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time).count() < total_seconds; ++i) {
+    if (storm_rate > 0) {
+        storm(engine, working_set, storm_rate, results, time_unit);
+        resize_time.benchmark = "resize_time => storm";
+        resize_time.samples = results.size();
+    }
+    else {
+        fmt::println("[ResizeTime] Starting benchmark, num iterations: {}", total_iterations);
+        // We keep track of both:
+        //  - how many seconds the bench should last at max (time.execution)
+        //  - how many iterations the benchmark should be repeated (time.execution)
+        // The first condition to be satisfied ends the benchmark.
+        const auto start_time = std::chrono::steady_clock::now();
+        auto current_time = start_time;
+        for (std::size_t i = 0; i < total_iterations
+            && std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time).count() < total_seconds; ++i) {
 
-        const auto start_bench = std::chrono::steady_clock::now();
-        const auto added = engine.addBucket();
-        engine.removeBucket(added);
-        const auto end_bench = std::chrono::steady_clock::now();
+            const auto start_bench = std::chrono::steady_clock::now();
+            const auto added = engine.addBucket();
+            engine.removeBucket(added);
+            const auto end_bench = std::chrono::steady_clock::now();
 
-        double elapsed_time_value = convert_elapsed_time_to(end_bench, start_bench, time_unit);
+            double elapsed_time_value = convert_elapsed_time_to(end_bench, start_bench, time_unit);
       
-        results.push_back(elapsed_time_value);
+            results.push_back(elapsed_time_value);
 
-        current_time = std::chrono::steady_clock::now();
+            current_time = std::chrono::steady_clock::now();
+        }
     }
 
     // For an explanation, see lookup_time.h.
@@ -98,6 +211,15 @@ inline void bench(const std::string& name,
     else {
         resize_time.score_error = std::numeric_limits<double>::quiet_NaN();
     }
+
+    // The mean hides the spikes: the slowest operation and the 99.9th
+    // percentile are reported too.
+    if (!results.empty()) {
+        const std::size_t p999 = (results.size() * 999 + 999) / 1000 - 1;
+        std::nth_element(results.begin(), results.begin() + p999, results.end());
+        resize_time.score_p999 = results[p999];
+        resize_time.score_max = *std::max_element(results.begin() + p999, results.end());
+    }
 }
 
 inline void resize_time(CsvWriter<ResizeTime>& resize_time_writer, 
@@ -108,6 +230,27 @@ inline void resize_time(CsvWriter<ResizeTime>& resize_time_writer,
     const uint32_t total_seconds = common_settings.secondsForEachIteration;
     const std::string time_unit = common_settings.unit;
 
+    // Optional growth scenario (e.g. grow-to: 1000000): instead of adding and
+    // removing a node, the cluster grows from each working set to grow-to
+    // nodes. The capacity is grow-to unless the algorithm sets it.
+    uint32_t grow_to = 0;
+    if (current_benchmark.args.count("grow-to")) {
+        grow_to = str_to<uint32_t>(current_benchmark.args.at("grow-to"), 0);
+    }
+    memory_usage.iterations = total_iterations;
+
+    // Optional removal storm (e.g. storm-rate: 0.5): instead of adding and
+    // removing a node, the given fraction of the working set is removed in a
+    // random order and then restored, and each operation is a sample.
+    double storm_rate = 0;
+    if (current_benchmark.args.count("storm-rate")) {
+        storm_rate = str_to<double>(current_benchmark.args.at("storm-rate"), 0);
+    }
+    if (storm_rate < 0 || storm_rate >= 1) {
+        fmt::println("[ResizeTime] Storm rate must be in the range [0, 1[. Continuing with default value storm-rate = 0.");
+        storm_rate = 0;
+    }
+
     for (const auto& hash_function : current_benchmark.commonSettings.hashFunctions) {
         for (const auto& current_algorithm : algorithms) {
             for (const auto& working_set : current_benchmark.commonSettings.numInitialActiveNodes) {
@@ -115,51 +258,144 @@ inline void resize_time(CsvWriter<ResizeTime>& resize_time_writer,
                 ResizeTime resize_time("resize_time => bench", common_settings.mode, 1, total_iterations,
                     common_settings.unit, current_algorithm.name, hash_function, working_set);
 
-                uint32_t capacity = working_set * 10; // default = 10
+                uint32_t capacity = grow_to > working_set ? grow_to : working_set * 10; // default = 10
                 if (current_algorithm.args.count("capacity")) {
                     capacity = str_to<uint32_t>(current_algorithm.args.at("capacity"), 10) * working_set;
                 }
+                resize_time.param_capacity = capacity;
+                memory_usage.algorithm = current_algorithm.name;
+                memory_usage.hash_function = hash_function;
                
                 if (current_algorithm.name == "anchor") {
                     bench<AnchorEngine>("Anchor", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
+                }
+                else if (current_algorithm.name == "anchor-fastmod") {
+                    bench<AnchorFastModEngine>("AnchorFastMod", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
                 }
                 else if (current_algorithm.name == "memento") {
                     bench<MementoEngine<boost::unordered_flat_map>>(
                         "Memento<boost::unordered_flat_map>", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "mementoboost") {
                     bench<MementoEngine<boost::unordered_map>>(
                         "Memento<boost::unordered_map>", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "mementostd") {
                     bench<MementoEngine<std::unordered_map>>(
                         "Memento<std::unordered_map>", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "mementogtl") {
                     bench<MementoEngine<gtl::flat_hash_map>>(
                         "Memento<std::gtl::flat_hash_map>", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "mementomash") {
                     bench<MementoEngine<MashTable>>("Memento<MashTable>",
                         capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "mementomash-incremental") {
+                    bench<MementoEngine<IncrementalMashTable>>("Memento<IncrementalMashTable>",
+                        capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "mementomash-arena") {
+                    bench<MementoEngine<ArenaMashTable>>("Memento<ArenaMashTable>",
+                        capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "mementodense") {
+                    bench<MementoEngine<DenseTable>>("Memento<DenseTable>",
+                        capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "mementoflat") {
+                    bench<MementoEngine<FlatTable>>("Memento<FlatTable>",
+                        capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "memento-power") {
+                    bench<MementoEngine<boost::unordered_flat_map, PowerEngine>>(
+                        "Memento<boost::unordered_flat_map, PowerEngine>", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "memento-binomial") {
+                    bench<MementoEngine<boost::unordered_flat_map, BinomialEngine>>(
+                        "Memento<boost::unordered_flat_map, BinomialEngine>", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "memento-fliphash") {
+                    bench<MementoEngine<boost::unordered_flat_map, FlipHashEngine>>(
+                        "Memento<boost::unordered_flat_map, FlipHashEngine>", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "jump") {
                     bench<JumpEngine>("JumpEngine", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "power") {
                     bench<PowerEngine>("PowerEngine", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "jumpback") {
+                    bench<JumpBackEngine>("JumpBackEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "binomial") {
+                    bench<BinomialEngine>("BinomialEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "maglev") {
+                    bench<MaglevEngine>("MaglevEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
+                }
+                else if (current_algorithm.name == "ring") {
+                    bench<RingEngine>("RingEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
+                }
+                else if (current_algorithm.name == "multiprobe") {
+                    bench<MultiProbeEngine>("MultiProbeEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
+                }
+                else if (current_algorithm.name == "rendezvous") {
+                    bench<RendezvousEngine>("RendezvousEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
+                }
+                else if (current_algorithm.name == "fliphash") {
+                    bench<FlipHashEngine>("FlipHashEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "power-fast") {
+                    bench<PowerFastEngine>("PowerFastEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "jump64") {
+                    bench<Jump64Engine>("Jump64Engine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
+                }
+                else if (current_algorithm.name == "power64") {
+                    bench<Power64Engine>("Power64Engine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else if (current_algorithm.name == "dx") {
                     bench<DxEngine>("DxEngine", capacity, working_set,
-                        total_iterations, total_seconds, resize_time, time_unit);
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate,
+                        current_algorithm.args);
+                }
+                else if (current_algorithm.name == "dx-fast") {
+                    bench<DxFastEngine>("DxFastEngine", capacity, working_set,
+                        total_iterations, total_seconds, resize_time, time_unit, grow_to, storm_rate);
                 }
                 else {
                     fmt::println("[ResizeTime] Unknown algorithm {}", current_algorithm.name);
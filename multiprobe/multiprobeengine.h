@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MULTIPROBEENGINE_H
+#define MULTIPROBEENGINE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "../utils.h"
+
+/*
+ * Multi-probe consistent hashing (B. Appleton, M. O'Reilly, 2015).
+ *
+ * Every bucket places a single point on a 64-bit ring. A key is hashed k times
+ * and is mapped to the bucket whose point is the closest successor of any of
+ * its k probes. With k = 21 the peak-to-average load is about 1.05, with one
+ * point per bucket instead of hundreds of virtual nodes.
+ *
+ * The points are kept in a sorted, cache-aligned array. The k successor
+ * searches run in lock-step: all of them halve a range of the same length at
+ * every step, so the k loads of a step are independent and a step has no
+ * branch other than the loop itself.
+ */
+class MultiProbeEngine final {
+public:
+    /**
+     * Creates a new MultiProbe engine.
+     *
+     * @param size initial number of working buckets (0 < size)
+     * @param args algorithm arguments (probes, default 21, at most 64)
+     */
+    MultiProbeEngine(uint32_t, uint32_t size, const engine_arguments& args = {})
+        : m_probes{DEFAULT_PROBES}, m_nextBucket{size}
+    {
+        if (args.count("probes")) {
+            m_probes = std::clamp<uint32_t>(
+                str_to<uint32_t>(args.at("probes"), DEFAULT_PROBES), 1, MAX_PROBES);
+        }
+
+        std::vector<std::pair<uint64_t, uint32_t>> sorted;
+        sorted.reserve(size);
+        for (uint32_t b = 0; b < size; ++b) {
+            sorted.emplace_back(point(b), b);
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        m_points.reserve(size);
+        m_owners.reserve(size);
+        for (const auto& [position, bucket] : sorted) {
+            m_points.push_back(position);
+            m_owners.push_back(bucket);
+        }
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        const uint64_t hash = crc32c_sse42_u64(key, seed);
+        const std::size_t n = m_points.size();
+        const uint64_t* points = m_points.data();
+
+        uint64_t probes[MAX_PROBES];
+        std::size_t base[MAX_PROBES];
+        for (uint32_t j = 0; j < m_probes; ++j) {
+            probes[j] = mix(hash + (static_cast<uint64_t>(j) + 1) * 0x9E3779B97F4A7C15ULL);
+            base[j] = 0;
+        }
+
+        // Branchless lower bound of every probe, one level at a time.
+        for (std::size_t len = n; len > 1;) {
+            const std::size_t half = len / 2;
+            for (uint32_t j = 0; j < m_probes; ++j) {
+                base[j] += points[base[j] + half] < probes[j] ? half : 0;
+            }
+            len -= half;
+        }
+
+        // The distance to the successor wraps around the ring with the
+        // unsigned subtraction; past the last point the successor is the first.
+        uint64_t best = std::numeric_limits<uint64_t>::max();
+        std::size_t closest = 0;
+        for (uint32_t j = 0; j < m_probes; ++j) {
+            std::size_t i = base[j] + (points[base[j]] < probes[j]);
+            i = i == n ? 0 : i;
+            const uint64_t distance = points[i] - probes[j];
+            closest = distance < best ? i : closest;
+            best = distance < best ? distance : best;
+        }
+        return m_owners[closest];
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   * The last removed bucket is restored if any.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket()
+    {
+        uint32_t bucket;
+        if (m_removed.empty()) {
+            bucket = m_nextBucket++;
+        }
+        else {
+            bucket = m_removed.back();
+            m_removed.pop_back();
+        }
+
+        const uint64_t position = point(bucket);
+        const auto it = std::lower_bound(m_points.begin(), m_points.end(), position);
+        m_owners.insert(m_owners.begin() + (it - m_points.begin()), bucket);
+        m_points.insert(it, position);
+        return bucket;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Only the keys of the bucket move, each to the closest successor
+   * of its probes among the remaining points.
+   *
+   * @param bucket the bucket to remove
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t bucket)
+    {
+        const auto it = std::lower_bound(m_points.begin(), m_points.end(), point(bucket));
+        m_owners.erase(m_owners.begin() + (it - m_points.begin()));
+        m_points.erase(it);
+        m_removed.push_back(bucket);
+        return bucket;
+    }
+
+    /**
+     * Returns the size of the working set.
+     *
+     * @return size of the working set.
+     */
+    uint32_t size() const noexcept { return m_points.size(); }
+
+private:
+
+    static constexpr uint32_t DEFAULT_PROBES = 21;
+
+    static constexpr uint32_t MAX_PROBES = 64;
+
+    static uint64_t mix(uint64_t x) noexcept
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Position of the bucket on the ring.
+    static uint64_t point(uint32_t bucket) noexcept
+    {
+        return mix(static_cast<uint64_t>(bucket) << 32 | 0xFFFFFFFFULL);
+    }
+
+    uint32_t m_probes;
+
+    /* Sorted points of the working buckets and the bucket of each point */
+    std::vector<uint64_t, aligned_allocator<uint64_t>> m_points;
+    std::vector<uint32_t> m_owners;
+
+    /* Removed buckets, restored in LIFO order */
+    std::vector<uint32_t> m_removed;
+    uint32_t m_nextBucket;
+};
+
+#endif // MULTIPROBEENGINE_H
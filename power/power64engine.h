@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POWER64ENGINE_H
+#define POWER64ENGINE_H
+#include <cstdint>
+#include <xxhash.h>
+#include "powerFastEngine.h"
+
+/*
+ * Power consistent hash on a 64-bit hash of the key.
+ *
+ * PowerEngine and PowerFastEngine take the 32-bit CRC32c of the key: at
+ * most 2^32 keys are told apart, so that with n buckets the number of hash
+ * values of a bucket varies with a relative standard deviation of
+ * sqrt(n/2^32) (5% at 10^7 buckets) however many keys are mapped. Here the
+ * key is hashed on 64 bits with XXH64, as in FlipHash, and the whole hash
+ * seeds the counter-based draws of PowerFastEngine: f still takes the
+ * log2(m) lowest bits, but every draw of f and g depends on the 64 bits.
+ * PowerEngine is not used since its g draws the same U at every step,
+ * which skews the balance much more than the width of the hash.
+ */
+class Power64Engine final {
+public:
+    Power64Engine(uint32_t, uint32_t working_nodes)
+        : m_n{working_nodes}
+    {}
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   * The key is hashed with XXH64, CRC32c is not used.
+   *
+   * @param key the key to map
+   * @param seed the seed of the hash function
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        return PowerFastEngine::bucketOf(XXH64(&key, sizeof(key), seed), m_n);
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket() noexcept { return m_n++; }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Since Power does not support random removals, it will always remove the
+   * last bucket.
+   *
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t) noexcept
+    {
+        return --m_n;
+    }
+
+    uint32_t size() const noexcept { return m_n; }
+
+private:
+    /* Number of nodes in the cluster */
+    uint32_t m_n;
+};
+
+#endif // POWER64ENGINE_H
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POWERFASTENGINE_H
+#define POWERFASTENGINE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <immintrin.h>
+#include "../utils.h"
+
+/*
+ * Power consistent hash whose random draws come from a counter-based
+ * generator instead of a pcg32 reseeded at every step: the draw number c of
+ * a key is the SplitMix64 finalizer of (hash, c), so that any draw costs
+ * two multiplications and needs no state.
+ *  - f(key, m) uses the draw number j (the most significant bit of the key
+ *    within m), as in PowerEngine;
+ *  - g(key, n, s) uses the draws 32, 33, ...: each step has its own
+ *    U = (u + 1) / 2^32 in (0, 1], as in the paper, whereas PowerEngine
+ *    reseeds with the key and draws the same U at every step. The next
+ *    x = ceil((x + 1) / U) - 1 is compared with n by a multiplication and
+ *    computed with an integer division only when it is below n: the
+ *    scalar lookup has no floating point.
+ * The buckets differ from PowerEngine's, but the engine keeps the balance
+ * and the minimal disruption of Power.
+ */
+class PowerFastEngine final {
+public:
+    PowerFastEngine(uint32_t, uint32_t working_nodes)
+        : m_n{working_nodes}
+    {
+        update();
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        return lookup(crc32c_sse42_u64(key, seed), m_n, m_mm1, m_mHm1);
+    }
+
+    /**
+   * Maps an already computed hash to a bucket in [0, n-1].
+   * Used by the engines built on top of PowerFast (e.g. Power64). Unlike
+   * PowerEngine::bucketOf, all the 64 bits of the hash seed the draws.
+   *
+   * @param hash the hash of the key
+   * @param n the number of buckets
+   * @return the related bucket
+   */
+    static uint32_t bucketOf(uint64_t hash, uint32_t n) noexcept
+    {
+        const uint64_t m = smallestPow2(n);
+        return lookup(hash, n, static_cast<uint32_t>(m - 1), static_cast<uint32_t>((m >> 1) - 1));
+    }
+
+    /**
+   * Maps a batch of keys to their buckets.
+   * With AVX-512, f runs for 8 keys at once, one per 64-bit lane; the keys
+   * that need g are packed and g and the second f run for 8 of them at
+   * once as well, until every lane has left the loop of g. The division of
+   * g is estimated in double precision and corrected with an integer
+   * multiplication, so that the result is exact. Without AVX-512, the keys
+   * go through the scalar version.
+   * The result for each key is the same as getBucketCRC32c(keys[i], seed).
+   *
+   * @param keys the keys to map
+   * @param seed the initial seed for CRC32c
+   * @param out the related buckets (at least keys.size() entries)
+   */
+    void getBucketsCRC32c(std::span<const uint64_t> keys, uint64_t seed,
+        std::span<uint32_t> out) const noexcept
+    {
+        std::size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512CD__) && defined(__BMI2__)
+        for (; i < keys.size(); i += CHUNK_SIZE) {
+            const auto n = static_cast<uint32_t>(std::min<std::size_t>(CHUNK_SIZE, keys.size() - i));
+            lookupChunkAVX512(&keys[i], seed, &out[i], n);
+        }
+#endif
+        for (; i < keys.size(); ++i) {
+            out[i] = getBucketCRC32c(keys[i], seed);
+        }
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket() noexcept
+    {
+        ++m_n;
+        update();
+        return m_n - 1;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Since Power does not support random removals, it will always remove the
+   * last bucket.
+   *
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t) noexcept
+    {
+        --m_n;
+        update();
+        return m_n;
+    }
+
+    uint32_t size() const noexcept { return m_n; }
+
+private:
+
+    /* Keys hashed at once by the batched lookup */
+    static constexpr uint32_t CHUNK_SIZE = 1024;
+
+    /* First draw of g, after the 32 draws that f may use */
+    static constexpr uint32_t G_DRAWS = 32;
+
+    static constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+    static constexpr uint64_t MIX_1 = 0xBF58476D1CE4E5B9ULL;
+    static constexpr uint64_t MIX_2 = 0x94D049BB133111EBULL;
+
+    // Draw number counter of the key.
+    static uint64_t draw(uint64_t key, uint32_t counter) noexcept
+    {
+        uint64_t z = key + (static_cast<uint64_t>(counter) + 1) * GOLDEN_GAMMA;
+        z = (z ^ (z >> 30)) * MIX_1;
+        z = (z ^ (z >> 27)) * MIX_2;
+        return z ^ (z >> 31);
+    }
+
+    static uint32_t lookup(uint64_t k, uint32_t n, uint32_t mm1, uint32_t mHm1) noexcept
+    {
+        // r1 = f (key, m)
+        const uint32_t r1 = f(k, mm1);
+        if (r1 < n) {
+            return r1;
+        }
+        // r2 = g(key, n, m/2 − 1)
+        const uint32_t r2 = g(k, n, mHm1);
+        if (r2 > mHm1) {
+            return r2;
+        }
+        // f (key, m/2)
+        return f(k, mHm1);
+    }
+
+    /**
+     * Algorithm-f, described in Section VI.A, pages 7 and 8
+     * (we pass m-1, the mask of the bits of the key).
+     */
+    static uint32_t f(uint64_t key, uint32_t mm1) noexcept
+    {
+        const uint32_t kBits = static_cast<uint32_t>(key) & mm1;
+        if (kBits == 0) {
+            return 0;
+        }
+        const uint32_t j = 31 - __builtin_clz(kBits);
+        const uint32_t h = static_cast<uint32_t>(1) << j;
+        return h + (static_cast<uint32_t>(draw(key, j)) & (h - 1));
+    }
+
+    /**
+     * Algorithm-g, described in Section VI.B, pages 8 and 9.
+     */
+    static uint32_t g(uint64_t key, uint32_t n, uint32_t s) noexcept
+    {
+        uint64_t x = s;
+        for (uint32_t c = G_DRAWS;; ++c) {
+            // U = u1 / 2^32, so that (x + 1) / U = a / u1
+            const uint64_t u1 = (draw(key, c) & 0xFFFFFFFF) + 1;
+            const uint64_t a = (x + 1) << 32;
+            // r = ceil(a / u1) - 1 is at least n when a / u1 > n
+            if (a > n * u1) {
+                return static_cast<uint32_t>(x);
+            }
+            x = (a - 1) / u1;
+        }
+    }
+
+    // Smallest power of 2 greater or equal to n, up to 2^32
+    static uint64_t smallestPow2(uint32_t n) noexcept
+    {
+        return n <= 1 ? 1 : static_cast<uint64_t>(2) << (31 - __builtin_clz(n - 1));
+    }
+
+    void update() noexcept
+    {
+        const uint64_t m = smallestPow2(m_n);
+        m_mm1 = static_cast<uint32_t>(m - 1);
+        m_mHm1 = static_cast<uint32_t>((m >> 1) - 1);
+    }
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512CD__) && defined(__BMI2__)
+    // Draws number counter of the keys of the lanes.
+    static __m512i drawAVX512(__m512i key, __m512i counter) noexcept
+    {
+        __m512i z = _mm512_add_epi64(key, _mm512_mullo_epi64(
+            _mm512_add_epi64(counter, _mm512_set1_epi64(1)), _mm512_set1_epi64(GOLDEN_GAMMA)));
+        z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 30)), _mm512_set1_epi64(MIX_1));
+        z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 27)), _mm512_set1_epi64(MIX_2));
+        return _mm512_xor_si512(z, _mm512_srli_epi64(z, 31));
+    }
+
+    // f for the keys of the lanes (mm1: m-1 in every lane).
+    static __m512i fAVX512(__m512i key, __m512i mm1) noexcept
+    {
+        const __m512i kBits = _mm512_and_si512(key, mm1);
+        const __mmask8 nonzero = _mm512_test_epi64_mask(kBits, kBits);
+        const __m512i j = _mm512_sub_epi64(_mm512_set1_epi64(63), _mm512_lzcnt_epi64(kBits));
+        const __m512i h = _mm512_sllv_epi64(_mm512_set1_epi64(1), j);
+        const __m512i d = drawAVX512(key, j);
+        return _mm512_maskz_add_epi64(nonzero, h,
+            _mm512_and_si512(d, _mm512_sub_epi64(h, _mm512_set1_epi64(1))));
+    }
+
+    // (a - 1) / u1 for a in [2^32, 2^64[ and u1 in [1, 2^32]: the quotient
+    // in double precision is off by at most one and then corrected.
+    static __m512i divideAVX512(__m512i a1, __m512i u1) noexcept
+    {
+        __m512i q = _mm512_cvttpd_epu64(_mm512_div_pd(_mm512_cvtepu64_pd(a1), _mm512_cvtepu64_pd(u1)));
+        const __m512i t = _mm512_mullo_epi64(q, u1);
+        const __mmask8 over = _mm512_cmpgt_epu64_mask(t, a1);
+        const __mmask8 under = _mm512_cmple_epu64_mask(_mm512_add_epi64(t, u1), a1) & ~over;
+        q = _mm512_mask_sub_epi64(q, over, q, _mm512_set1_epi64(1));
+        return _mm512_mask_add_epi64(q, under, q, _mm512_set1_epi64(1));
+    }
+
+    /*
+     * Two passes over the chunk: f for all the keys in lockstep, the keys
+     * with r1 >= n (at most half of them) being packed with their index;
+     * then g and the second f for the packed keys, 8 at a time. The lanes of
+     * a group of g run until the last one is done, a few steps on average.
+     */
+    void lookupChunkAVX512(const uint64_t* keys, uint64_t seed, uint32_t* out, uint32_t n) const noexcept
+    {
+        alignas(64) uint64_t hashes[CHUNK_SIZE];
+        alignas(64) uint64_t pending_hashes[CHUNK_SIZE];
+        alignas(64) uint64_t pending_index[CHUNK_SIZE];
+        for (uint32_t l = 0; l < n; ++l) {
+            hashes[l] = crc32c_sse42_u64(keys[l], seed);
+        }
+
+        const __m512i size = _mm512_set1_epi64(m_n);
+        const __m512i mm1 = _mm512_set1_epi64(m_mm1);
+        const __m512i mHm1 = _mm512_set1_epi64(m_mHm1);
+        const __m512i lanes = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+
+        uint32_t pending = 0;
+        for (uint32_t l = 0; l < n; l += 8) {
+            const __mmask8 active = static_cast<__mmask8>(_bzhi_u32(0xFF, std::min(n - l, 8u)));
+            const __m512i k = _mm512_maskz_load_epi64(active, hashes + l);
+            const __m512i r1 = fAVX512(k, mm1);
+            const __mmask8 done = _mm512_mask_cmplt_epu64_mask(active, r1, size);
+            _mm512_mask_cvtepi64_storeu_epi32(out + l, done, r1);
+            const __mmask8 rest = active & ~done;
+            _mm512_mask_compressstoreu_epi64(pending_hashes + pending, rest, k);
+            _mm512_mask_compressstoreu_epi64(pending_index + pending, rest,
+                _mm512_add_epi64(_mm512_set1_epi64(l), lanes));
+            pending += _mm_popcnt_u32(rest);
+        }
+
+        for (uint32_t l = 0; l < pending; l += 8) {
+            const __mmask8 active = static_cast<__mmask8>(_bzhi_u32(0xFF, std::min(pending - l, 8u)));
+            const __m512i k = _mm512_maskz_load_epi64(active, pending_hashes + l);
+            const __m512i index = _mm512_maskz_load_epi64(active, pending_index + l);
+
+            // g(key, n, m/2 - 1), see g
+            __m512i x = mHm1;
+            __m512i c = _mm512_set1_epi64(G_DRAWS);
+            for (__mmask8 live = active; live;) {
+                const __m512i u1 = _mm512_add_epi64(_mm512_and_si512(drawAVX512(k, c),
+                    _mm512_set1_epi64(0xFFFFFFFF)), _mm512_set1_epi64(1));
+                const __m512i a = _mm512_slli_epi64(_mm512_add_epi64(x, _mm512_set1_epi64(1)), 32);
+                live &= _mm512_cmple_epu64_mask(a, _mm512_mullo_epi64(size, u1));
+                x = _mm512_mask_mov_epi64(x, live,
+                    divideAVX512(_mm512_sub_epi64(a, _mm512_set1_epi64(1)), u1));
+                c = _mm512_add_epi64(c, _mm512_set1_epi64(1));
+            }
+
+            // r2 if r2 > m/2 - 1, otherwise f(key, m/2)
+            const __mmask8 low = _mm512_cmple_epu64_mask(x, mHm1);
+            const __m512i r = _mm512_mask_mov_epi64(x, low, fAVX512(k, mHm1));
+            _mm512_mask_i64scatter_epi32(out, active, index, _mm512_cvtepi64_epi32(r), 4);
+        }
+    }
+#endif
+
+    /* Number of nodes in the cluster */
+    uint32_t m_n;
+
+    /* Smallest power of 2 greater or equal to n, minus 1 */
+    uint32_t m_mm1;
+
+    /* Half of that power of 2, minus 1 */
+    uint32_t m_mHm1;
+};
+
+#endif // POWERFASTENGINE_H
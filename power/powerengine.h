@@ -36,20 +36,22 @@ public:
    */
     uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) noexcept
     {
-        pcg32 rng;
-        auto k = crc32c_sse42_u64(key, seed);
-        // r1 = f (key, m) (we pass m-1 because f expects that)
-        auto r1 = f(k, m_mm1, rng);
-        if (r1 < m_n) {
-            return r1;
-        }
-        // r2 = g(key, n, m/2 − 1)
-        auto r2 = g(k, m_n, m_mHm1, rng);
-        if (r2 > m_mHm1) {
-            return r2;
-        }
-        // f (key, m/2) (we pass m/2-1 because f expects that)
-        return f(k, m_mHm1, rng);
+        return lookup(crc32c_sse42_u64(key, seed), m_n, m_mm1, m_mHm1);
+    }
+
+    /**
+   * Maps an already computed hash to a bucket in [0, n-1].
+   * Used by the engines built on top of Power (e.g. Memento).
+   * Only the 32 lowest bits of the hash are used.
+   *
+   * @param hash the hash of the key
+   * @param n the number of buckets
+   * @return the related bucket
+   */
+    static uint32_t bucketOf(uint64_t hash, uint32_t n) noexcept
+    {
+        const uint32_t m = smallestPow2(n);
+        return lookup(static_cast<uint32_t>(hash), n, m - 1, (m >> 1) - 1);
     }
 
     /**
@@ -83,6 +85,23 @@ public:
 
 private:
 
+    static uint32_t lookup(uint32_t k, uint32_t n, uint32_t mm1, uint32_t mHm1) noexcept
+    {
+        pcg32 rng;
+        // r1 = f (key, m) (we pass m-1 because f expects that)
+        auto r1 = f(k, mm1, rng);
+        if (r1 < n) {
+            return r1;
+        }
+        // r2 = g(key, n, m/2 − 1)
+        auto r2 = g(k, n, mHm1, rng);
+        if (r2 > mHm1) {
+            return r2;
+        }
+        // f (key, m/2) (we pass m/2-1 because f expects that)
+        return f(k, mHm1, rng);
+    }
+
     static uint32_t smallestPow2(uint32_t x) {
         --x;
         x |= x >> 1;
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RENDEZVOUSENGINE_H
+#define RENDEZVOUSENGINE_H
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include "../utils.h"
+
+/*
+ * Rendezvous, or highest random weight, hashing (D. Thaler, C. Ravishankar, 1998).
+ *
+ * Every (key, bucket) pair gets a pseudo-random score and the key is mapped to
+ * the working bucket with the highest score. Removing a bucket only moves its
+ * own keys, and adding a bucket only moves keys to it, whatever the bucket.
+ *
+ * Two modes are available through the "mode" argument:
+ * - flat (default): the scores of all the working buckets are computed, 8 per
+ *   instruction with AVX-512 (4 with AVX2), so a lookup is O(n).
+ * - skeleton: bucket ids are the leaves of a virtual tree with "fanout"
+ *   children per node (default 8, at least 2). The path of a bucket follows
+ *   its digits in base fanout, lowest first: the node at depth t holding
+ *   bucket b is b mod fanout^t, so the first buckets spread evenly and two
+ *   sibling subtrees differ by at most one bucket until buckets are removed.
+ *   Every node counts the working buckets of its subtree. A lookup descends
+ *   once from the root, taking at every node the child with the highest score
+ *   among the children whose subtree has a working bucket, so it is
+ *   O(fanout * log_fanout(n)) whatever the removals. A removal only empties
+ *   the subtrees whose last working bucket it was, so only the keys of the
+ *   removed bucket move; an addition only makes the subtrees holding the added
+ *   bucket non-empty, so keys only move to it. The children are not weighted
+ *   by their number of working buckets, which would move other keys: after
+ *   many removals, a bucket left alone in a subtree gets as many keys as its
+ *   siblings' whole subtrees.
+ *   When the ids outgrow the tree, the leaves become inner nodes whose first
+ *   child is the bucket itself, and the seed of a node does not depend on the
+ *   height of the tree, so keys only move to the added buckets.
+ *
+ * No capacity is needed: the engine grows with the buckets it has seen.
+ */
+class RendezvousEngine final {
+public:
+    /**
+     * Creates a new Rendezvous engine.
+     *
+     * @param size initial number of working buckets (0 < size)
+     * @param args algorithm arguments (mode: flat or skeleton, fanout)
+     */
+    RendezvousEngine(uint32_t, uint32_t size, const engine_arguments& args = {})
+        : m_skeleton{false}, m_fanout{DEFAULT_FANOUT}, m_levels{0}, m_leaves{1}, m_size{0}
+    {
+        if (args.count("mode")) {
+            m_skeleton = args.at("mode") == "skeleton";
+        }
+        if (args.count("fanout")) {
+            m_fanout = std::max<uint32_t>(str_to<uint32_t>(args.at("fanout"), DEFAULT_FANOUT), 2);
+        }
+        for (uint32_t c = 0; c < m_fanout; ++c) {
+            m_childSeeds.push_back(mix(c + 0x9E3779B97F4A7C15ULL));
+        }
+        for (uint32_t b = 0; b < size; ++b) {
+            insert(b);
+        }
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket, NO_BUCKET if no bucket is working
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        if (m_size == 0) {
+            return NO_BUCKET;
+        }
+        const uint64_t hash = crc32c_sse42_u64(key, seed);
+        if (!m_skeleton) {
+            return m_ids[highestScore(hash, m_seeds.data(), m_seeds.size())];
+        }
+
+        // The children of the node r at depth t are r + c * fanout^t.
+        uint64_t node = 0;
+        uint64_t span = 1;
+        for (uint32_t depth = 0; depth < m_levels; ++depth, span *= m_fanout) {
+            const uint64_t h = mix(hash ^ nodeSeed(depth, node));
+            uint64_t next = node;
+            uint64_t best = 0;
+            bool found = false;
+            for (uint32_t c = 0; c < m_fanout; ++c) {
+                const uint64_t child = node + c * span;
+                if (child >= m_working.size()) {
+                    break;
+                }
+                if (!working(depth + 1, child)) {
+                    continue;
+                }
+                const uint64_t score = mix(h ^ m_childSeeds[c]);
+                if (!found || score > best) {
+                    best = score;
+                    next = child;
+                    found = true;
+                }
+            }
+            node = next;
+        }
+        return node;
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   * The last removed bucket is restored if any.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket()
+    {
+        uint32_t bucket;
+        if (m_removed.empty()) {
+            bucket = m_skeleton ? m_working.size() : m_position.size();
+        }
+        else {
+            bucket = m_removed.back();
+            m_removed.pop_back();
+        }
+        insert(bucket);
+        return bucket;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   *
+   * @param bucket the bucket to remove
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t bucket)
+    {
+        --m_size;
+        m_removed.push_back(bucket);
+        if (m_skeleton) {
+            m_working[bucket] = 0;
+            uint64_t span = 1;
+            for (auto& counts : m_counts) {
+                --counts[bucket % span];
+                span *= m_fanout;
+            }
+            return bucket;
+        }
+
+        // Swap-remove: the order of the scores does not matter.
+        const uint32_t position = m_position[bucket];
+        m_seeds[position] = m_seeds.back();
+        m_ids[position] = m_ids.back();
+        m_position[m_ids[position]] = position;
+        m_seeds.pop_back();
+        m_ids.pop_back();
+        return bucket;
+    }
+
+    /**
+     * Returns the size of the working set.
+     *
+     * @return size of the working set.
+     */
+    uint32_t size() const noexcept { return m_size; }
+
+    /* Returned by the lookups when no bucket is working */
+    static constexpr uint32_t NO_BUCKET = std::numeric_limits<uint32_t>::max();
+
+private:
+
+    static constexpr uint32_t DEFAULT_FANOUT = 8;
+
+    static uint64_t mix(uint64_t x) noexcept
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Seed of a node of the virtual tree.
+    static uint64_t nodeSeed(uint32_t depth, uint64_t node) noexcept
+    {
+        return mix(node * 0x9E3779B97F4A7C15ULL + depth);
+    }
+
+    // Whether the subtree of the node (a bucket at depth m_levels) has a working bucket.
+    bool working(uint32_t depth, uint64_t node) const noexcept
+    {
+        if (depth == m_levels) {
+            return m_working[node];
+        }
+        return m_counts[depth][node] > 0;
+    }
+
+    void insert(uint32_t bucket)
+    {
+        if (m_skeleton) {
+            if (bucket == m_working.size()) {
+                m_working.push_back(0);
+                while (m_leaves < m_working.size()) {
+                    // The leaves become inner nodes, each holding its bucket.
+                    m_counts.emplace_back(m_working.begin(),
+                        m_working.begin() + std::min<uint64_t>(m_leaves, m_working.size() - 1));
+                    m_leaves *= m_fanout;
+                    ++m_levels;
+                }
+                // The nodes at depth t are the residues modulo fanout^t.
+                uint64_t span = 1;
+                for (auto& counts : m_counts) {
+                    counts.resize(std::min<uint64_t>(span, m_working.size()));
+                    span *= m_fanout;
+                }
+            }
+            m_working[bucket] = 1;
+            uint64_t span = 1;
+            for (auto& counts : m_counts) {
+                ++counts[bucket % span];
+                span *= m_fanout;
+            }
+            ++m_size;
+            return;
+        }
+
+        ++m_size;
+
+        if (bucket >= m_position.size()) {
+            m_position.resize(bucket + 1);
+        }
+        m_position[bucket] = m_seeds.size();
+        m_seeds.push_back(mix(bucket + 0x9E3779B97F4A7C15ULL));
+        m_ids.push_back(bucket);
+    }
+
+    /*
+     * Returns the position of the highest score mix(hash ^ seeds[i]) among
+     * the n seeds. Ties go to the smallest position, like in the scalar loop.
+     */
+    static uint32_t highestScore(uint64_t hash, const uint64_t* seeds, std::size_t n) noexcept
+    {
+        uint64_t best = 0;
+        uint32_t position = 0;
+        std::size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+        if (n >= 8) {
+            const __m512i h = _mm512_set1_epi64(hash);
+            const __m512i eight = _mm512_set1_epi64(8);
+            __m512i bestScore = _mm512_setzero_si512();
+            __m512i bestIndex = _mm512_setzero_si512();
+            __m512i index = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+            for (; i + 8 <= n; i += 8) {
+                const __m512i s = mix512(_mm512_xor_si512(h, _mm512_loadu_si512(seeds + i)));
+                const __mmask8 higher = _mm512_cmpgt_epu64_mask(s, bestScore);
+                bestScore = _mm512_mask_mov_epi64(bestScore, higher, s);
+                bestIndex = _mm512_mask_mov_epi64(bestIndex, higher, index);
+                index = _mm512_add_epi64(index, eight);
+            }
+            best = _mm512_reduce_max_epu64(bestScore);
+            const __mmask8 lanes = _mm512_cmpeq_epu64_mask(bestScore, _mm512_set1_epi64(best));
+            position = static_cast<uint32_t>(_mm512_mask_reduce_min_epu64(lanes, bestIndex));
+        }
+#elif defined(__AVX2__)
+        if (n >= 4) {
+            // AVX2 only compares signed integers: flipping the sign bit
+            // turns the unsigned order into the signed one.
+            const __m256i h = _mm256_set1_epi64x(hash);
+            const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+            const __m256i four = _mm256_set1_epi64x(4);
+            __m256i bestScore = sign;
+            __m256i bestIndex = _mm256_setzero_si256();
+            __m256i index = _mm256_setr_epi64x(0, 1, 2, 3);
+            for (; i + 4 <= n; i += 4) {
+                const __m256i s = _mm256_xor_si256(mix256(_mm256_xor_si256(h,
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seeds + i)))), sign);
+                const __m256i higher = _mm256_cmpgt_epi64(s, bestScore);
+                bestScore = _mm256_blendv_epi8(bestScore, s, higher);
+                bestIndex = _mm256_blendv_epi8(bestIndex, index, higher);
+                index = _mm256_add_epi64(index, four);
+            }
+            alignas(32) uint64_t scores[4];
+            alignas(32) uint64_t indexes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(scores), _mm256_xor_si256(bestScore, sign));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indexes), bestIndex);
+            best = scores[0];
+            position = indexes[0];
+            for (int l = 1; l < 4; ++l) {
+                if (scores[l] > best || (scores[l] == best && indexes[l] < position)) {
+                    best = scores[l];
+                    position = indexes[l];
+                }
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            const uint64_t s = mix(hash ^ seeds[i]);
+            if (s > best) {
+                best = s;
+                position = i;
+            }
+        }
+        return position;
+    }
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+    static __m512i mix512(__m512i x) noexcept
+    {
+        x = _mm512_mullo_epi64(_mm512_xor_si512(x, _mm512_srli_epi64(x, 30)),
+            _mm512_set1_epi64(0xBF58476D1CE4E5B9ULL));
+        x = _mm512_mullo_epi64(_mm512_xor_si512(x, _mm512_srli_epi64(x, 27)),
+            _mm512_set1_epi64(0x94D049BB133111EBULL));
+        return _mm512_xor_si512(x, _mm512_srli_epi64(x, 31));
+    }
+#elif defined(__AVX2__)
+    // AVX2 has no 64-bit multiply, so we build it from 32x32->64 products.
+    static __m256i mullo64(__m256i a, __m256i b) noexcept
+    {
+        const __m256i lo = _mm256_mul_epu32(a, b);
+        const __m256i hi = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+            _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+        return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    }
+
+    static __m256i mix256(__m256i x) noexcept
+    {
+        x = mullo64(_mm256_xor_si256(x, _mm256_srli_epi64(x, 30)),
+            _mm256_set1_epi64x(0xBF58476D1CE4E5B9ULL));
+        x = mullo64(_mm256_xor_si256(x, _mm256_srli_epi64(x, 27)),
+            _mm256_set1_epi64x(0x94D049BB133111EBULL));
+        return _mm256_xor_si256(x, _mm256_srli_epi64(x, 31));
+    }
+#endif
+
+    bool m_skeleton;
+    uint32_t m_fanout;
+
+    /* Skeleton mode: height of the virtual tree and its number of leaves, fanout^levels */
+    uint32_t m_levels;
+    uint64_t m_leaves;
+
+    uint32_t m_size;
+
+    /* Flat mode: seeds and ids of the working buckets, position of each bucket */
+    std::vector<uint64_t, aligned_allocator<uint64_t>> m_seeds;
+    std::vector<uint32_t> m_ids;
+    std::vector<uint32_t> m_position;
+
+    /* Skeleton mode: seed of every child position and working flag of every bucket id */
+    std::vector<uint64_t, aligned_allocator<uint64_t>> m_childSeeds;
+    std::vector<uint8_t> m_working;
+
+    /* Skeleton mode: working buckets in the subtree of every node, for the depths 0 to m_levels - 1 */
+    std::vector<std::vector<uint32_t>> m_counts;
+
+    /* Removed buckets, restored in LIFO order */
+    std::vector<uint32_t> m_removed;
+};
+
+#endif // RENDEZVOUSENGINE_H
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2023 Amos Brocco.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RINGENGINE_H
+#define RINGENGINE_H
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "../utils.h"
+
+/*
+ * Consistent hashing on a ring (D. Karger et al., 1997).
+ *
+ * Every bucket places virtualNodes points on a 64-bit ring, and a key belongs
+ * to the first point clockwise from its position. The points are stored in
+ * Eytzinger (BFS) order, so the search is a branchless descent where the
+ * next levels are prefetched, instead of a binary search over a sorted array.
+ *
+ * The points of a removed bucket stay on the ring: they redirect to the
+ * bucket of the next working point, so removing or restoring a bucket only
+ * updates the points between its points and their predecessors.
+ */
+class RingEngine final {
+public:
+    /**
+     * Creates a new Ring engine.
+     *
+     * @param size initial number of working buckets (0 < size)
+     * @param args algorithm arguments (virtualNodes, default 1000)
+     */
+    RingEngine(uint32_t, uint32_t size, const engine_arguments& args = {})
+        : m_virtualNodes{DEFAULT_VIRTUAL_NODES}, m_size{size}
+    {
+        if (args.count("virtualNodes")) {
+            m_virtualNodes = str_to<uint32_t>(args.at("virtualNodes"), DEFAULT_VIRTUAL_NODES);
+        }
+        m_working.assign(size, 1);
+        build();
+    }
+
+    /**
+   * Returns the bucket where the given key should be mapped.
+   *
+   * @param key the key to map
+   * @param seed the initial seed for CRC32c
+   * @return the related bucket
+   */
+    uint32_t getBucketCRC32c(uint64_t key, uint64_t seed) const noexcept
+    {
+        const uint64_t position = mix(crc32c_sse42_u64(key, seed));
+        const std::size_t n = m_keys.size() - 1;
+        const uint64_t* keys = m_keys.data();
+
+        // Lower bound in Eytzinger order: go right while the point is
+        // before the key. The levels 3 steps ahead share a cache line.
+        std::size_t k = 1;
+        while (k <= n) {
+            __builtin_prefetch(keys + k * 8);
+            k = 2 * k + (keys[k] < position);
+        }
+        // Undo the right turns taken after the last left turn.
+        k >>= __builtin_ffsll(~k);
+
+        // Past the last point: wrap around to the first one.
+        return m_owner[k ? k : m_first];
+    }
+
+    /**
+   * Adds a new bucket to the engine.
+   * The last removed bucket is restored if any, otherwise a new
+   * bucket is placed on the ring.
+   *
+   * @return the added bucket
+   */
+    uint32_t addBucket()
+    {
+        ++m_size;
+        if (m_removed.empty()) {
+            const uint32_t bucket = m_working.size();
+            m_working.push_back(1);
+            build();
+            return bucket;
+        }
+
+        const uint32_t bucket = m_removed.back();
+        m_removed.pop_back();
+        m_working[bucket] = 1;
+        for (const uint32_t i : m_points[bucket]) {
+            redirect(i, bucket);
+        }
+        return bucket;
+    }
+
+    /**
+   * Removes the given bucket from the engine.
+   * Its points are taken over by the next working point.
+   *
+   * @param bucket the bucket to remove
+   * @return the removed bucket
+   */
+    uint32_t removeBucket(uint32_t bucket)
+    {
+        --m_size;
+        m_working[bucket] = 0;
+        m_removed.push_back(bucket);
+        for (const uint32_t i : m_points[bucket]) {
+            std::size_t j = next(i);
+            while (!m_working[m_bucket[j]] && j != i) {
+                j = next(j);
+            }
+            redirect(i, m_bucket[j]);
+        }
+        return bucket;
+    }
+
+    /**
+     * Returns the size of the working set.
+     *
+     * @return size of the working set.
+     */
+    uint32_t size() const noexcept { return m_size; }
+
+private:
+
+    static constexpr uint32_t DEFAULT_VIRTUAL_NODES = 1000;
+
+    static uint64_t mix(uint64_t x) noexcept
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    std::size_t next(std::size_t i) const noexcept
+    {
+        return i + 1 == m_bucket.size() ? 0 : i + 1;
+    }
+
+    std::size_t prev(std::size_t i) const noexcept
+    {
+        return i == 0 ? m_bucket.size() - 1 : i - 1;
+    }
+
+    /*
+     * Sets the owner of the point with sorted index i, and of the points of
+     * removed buckets right before it (those redirect to the same bucket).
+     */
+    void redirect(std::size_t i, uint32_t owner) noexcept
+    {
+        m_owner[m_eytzinger[i]] = owner;
+        for (std::size_t j = prev(i); j != i && !m_working[m_bucket[j]]; j = prev(j)) {
+            m_owner[m_eytzinger[j]] = owner;
+        }
+    }
+
+    // Lays out the sorted points in Eytzinger order (in-order visit of the implicit tree).
+    std::size_t layout(const std::vector<std::pair<uint64_t, uint32_t>>& sorted,
+        std::size_t i, std::size_t k)
+    {
+        if (k < m_keys.size()) {
+            i = layout(sorted, i, 2 * k);
+            m_keys[k] = sorted[i].first;
+            m_eytzinger[i] = k;
+            i = layout(sorted, i + 1, 2 * k + 1);
+        }
+        return i;
+    }
+
+    // Places the points of every bucket (working or removed) on the ring.
+    void build()
+    {
+        const uint32_t buckets = m_working.size();
+        std::vector<std::pair<uint64_t, uint32_t>> sorted;
+        sorted.reserve(static_cast<std::size_t>(buckets) * m_virtualNodes);
+        for (uint32_t b = 0; b < buckets; ++b) {
+            for (uint32_t v = 0; v < m_virtualNodes; ++v) {
+                sorted.emplace_back(mix((static_cast<uint64_t>(b) << 32 | v) + 0x9E3779B97F4A7C15ULL), b);
+            }
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        m_keys.assign(sorted.size() + 1, 0);
+        m_owner.assign(sorted.size() + 1, 0);
+        m_eytzinger.assign(sorted.size(), 0);
+        m_bucket.resize(sorted.size());
+        m_points.assign(buckets, {});
+        layout(sorted, 0, 1);
+        m_first = sorted.empty() ? 0 : m_eytzinger[0];
+
+        for (std::size_t i = 0; i < sorted.size(); ++i) {
+            m_bucket[i] = sorted[i].second;
+            m_points[sorted[i].second].push_back(i);
+        }
+
+        // Owners are assigned backward from a working point, so that every
+        // point of a removed bucket takes the owner of its successor.
+        std::size_t start = 0;
+        while (start < m_bucket.size() && !m_working[m_bucket[start]]) {
+            ++start;
+        }
+        if (start == m_bucket.size()) {
+            return;
+        }
+        uint32_t owner = m_bucket[start];
+        std::size_t i = start;
+        do {
+            if (m_working[m_bucket[i]]) {
+                owner = m_bucket[i];
+            }
+            m_owner[m_eytzinger[i]] = owner;
+            i = prev(i);
+        } while (i != start);
+    }
+
+    uint32_t m_virtualNodes;
+    uint32_t m_size;
+
+    /* Points in Eytzinger order (1-based): position and current owner */
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_owner;
+    std::size_t m_first;
+
+    /* Points in ring order: Eytzinger index and bucket that placed the point */
+    std::vector<uint32_t> m_eytzinger;
+    std::vector<uint32_t> m_bucket;
+
+    /* Ring order indexes of the points of each bucket */
+    std::vector<std::vector<uint32_t>> m_points;
+
+    /* Working flag of every bucket ever added */
+    std::vector<uint8_t> m_working;
+
+    /* Removed buckets, restored in LIFO order */
+    std::vector<uint32_t> m_removed;
+};
+
+#endif // RINGENGINE_H
@@ -0,0 +1,671 @@
+#include <gtest/gtest.h>
+#include "../anchor/anchorengine.h"
+#include "../jump/jumpengine.h"
+#include "../jump/jumpbackengine.h"
+#include "../jump/jump64engine.h"
+#include "../binomial/binomialengine.h"
+#include "../fliphash/fliphashengine.h"
+#include "../maglev/maglevengine.h"
+#include "../ring/ringengine.h"
+#include "../multiprobe/multiprobeengine.h"
+#include "../rendezvous/rendezvousengine.h"
+#include "../power/powerengine.h"
+#include "../power/powerFastEngine.h"
+#include "../power/power64engine.h"
+#include "../dx/dxEngine.h"
+#include "../dx/dxFastEngine.h"
+#include "../memento/mementoengine.h"
+#include "../memento/densetable.h"
+#include "../memento/flattable.h"
+#include "../memento/mashtable.h"
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+
+// Checks that the batched lookup of an engine maps every key to the same
+// bucket as the scalar lookup.
+template<typename Engine>
+void expect_batch_matches_scalar(Engine& engine, std::size_t num_keys) {
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> keys(num_keys);
+    for (auto& key : keys) {
+        key = rng();
+    }
+    const uint64_t seed = rng();
+
+    std::vector<uint32_t> buckets(num_keys);
+    engine.getBucketsCRC32c(keys, seed, buckets);
+    for (std::size_t i = 0; i < num_keys; ++i) {
+        ASSERT_EQ(buckets[i], engine.getBucketCRC32c(keys[i], seed)) << "key index " << i;
+    }
+}
+
+
+// Checks that growing the engine by one bucket only moves keys to the new
+// bucket, and that every bucket receives some keys.
+template<typename Engine>
+void expect_minimal_disruption_on_add(Engine& engine, uint32_t size, std::size_t num_keys) {
+    std::mt19937_64 rng(7);
+    std::vector<std::pair<uint64_t, uint64_t>> keys(num_keys);
+    std::vector<uint32_t> before(num_keys);
+    std::vector<uint32_t> keys_per_bucket(size + 1);
+    for (std::size_t i = 0; i < num_keys; ++i) {
+        keys[i] = { rng(), rng() };
+        before[i] = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+        ASSERT_LT(before[i], size);
+    }
+
+    const auto added = engine.addBucket();
+    for (std::size_t i = 0; i < num_keys; ++i) {
+        const auto after = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+        EXPECT_TRUE(after == before[i] || after == added);
+        keys_per_bucket[after]++;
+    }
+    for (const auto count : keys_per_bucket) {
+        EXPECT_GT(count, 0u);
+    }
+}
+
+
+// Removes the given buckets in turn, then applies random_steps random updates
+// (adding a bucket in add_percent of them, removing a random working bucket
+// otherwise), and checks that each update only moves keys from or to the
+// bucket it changed. The working buckets must initially be [0, size).
+template<typename Engine>
+void expect_removal_only_moves_keys_of_removed_bucket(Engine& engine, uint32_t size,
+    std::initializer_list<uint32_t> removed, int random_steps = 0, uint32_t add_percent = 0) {
+    std::mt19937_64 rng(23);
+    std::vector<std::pair<uint64_t, uint64_t>> keys(10000);
+    std::vector<uint32_t> before(keys.size());
+    std::vector<bool> working(size, true);
+    std::size_t working_size = size;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = { rng(), rng() };
+        before[i] = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+        ASSERT_LT(before[i], size);
+    }
+
+    auto check = [&](uint32_t changed) {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const auto after = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+            ASSERT_TRUE(after < working.size() && working[after]);
+            if (after != before[i]) {
+                ASSERT_TRUE(before[i] == changed || after == changed);
+            }
+            before[i] = after;
+        }
+    };
+    auto remove = [&](uint32_t bucket) {
+        engine.removeBucket(bucket);
+        working[bucket] = false;
+        --working_size;
+        check(bucket);
+    };
+
+    for (const uint32_t bucket : removed) {
+        remove(bucket);
+    }
+
+    std::mt19937 order(5);
+    for (int step = 0; step < random_steps; ++step) {
+        if (order() % 100 < add_percent || working_size < 2) {
+            const auto added = engine.addBucket();
+            working.resize(std::max<std::size_t>(working.size(), added + 1));
+            ASSERT_FALSE(working[added]);
+            working[added] = true;
+            ++working_size;
+            check(added);
+        }
+        else {
+            uint32_t bucket;
+            do {
+                bucket = order() % working.size();
+            } while (!working[bucket]);
+            remove(bucket);
+        }
+    }
+}
+
+
+TEST(JumpEngineTest, BatchMatchesScalar) {
+    for (uint32_t size : { 1u, 2u, 10u, 1000u, 123457u, 100000000u, 4000000000u }) {
+        JumpEngine engine(size, size);
+        expect_batch_matches_scalar(engine, 1003);
+    }
+}
+
+TEST(JumpEngineTest, BatchMatchesScalarAfterResize) {
+    JumpEngine engine(100, 100);
+    for (int i = 0; i < 37; ++i) {
+        engine.removeBucket(0);
+    }
+    expect_batch_matches_scalar(engine, 517);
+    engine.addBucket();
+    expect_batch_matches_scalar(engine, 517);
+}
+
+TEST(AnchorEngineTest, BatchMatchesScalarAfterRandomRemovals) {
+    for (uint32_t capacity : { 10u, 1000u, 100000u }) {
+        AnchorEngine engine(capacity, capacity / 2);
+        std::vector<uint32_t> working(capacity / 2);
+        std::iota(working.begin(), working.end(), 0);
+        std::shuffle(working.begin(), working.end(), std::mt19937(capacity));
+        for (uint32_t i = 0; i < capacity / 5; ++i) {
+            engine.removeBucket(working[i]);
+        }
+        expect_batch_matches_scalar(engine, 4099);
+        engine.addBucket();
+        expect_batch_matches_scalar(engine, 4099);
+    }
+}
+
+TEST(AnchorEngineTest, LayoutsIndexWidthsAndLazyInitAgree) {
+    for (uint32_t capacity : { 1000u, 40000u }) {
+        std::vector<std::unique_ptr<AnchorEngine>> engines;
+        for (const char* init : { "eager", "lazy" }) {
+            for (const char* layout : { "split", "interleaved" }) {
+                for (const char* width : { "16", "32" }) {
+                    engines.push_back(std::make_unique<AnchorEngine>(capacity, capacity / 2,
+                        engine_arguments{ { "init", init }, { "layout", layout }, { "index-width", width } }));
+                }
+            }
+        }
+        std::vector<uint32_t> working(capacity / 2);
+        std::iota(working.begin(), working.end(), 0);
+        std::shuffle(working.begin(), working.end(), std::mt19937(capacity));
+        for (uint32_t i = 0; i < capacity / 5; ++i) {
+            for (auto& engine : engines) {
+                engine->removeBucket(working[i]);
+            }
+        }
+        // Restores all the removed buckets and some of the initial removals.
+        for (uint32_t i = 0; i < capacity / 4; ++i) {
+            const uint32_t expected = engines[0]->addBucket();
+            for (std::size_t e = 1; e < engines.size(); ++e) {
+                ASSERT_EQ(engines[e]->addBucket(), expected);
+            }
+        }
+
+        std::mt19937_64 rng(capacity);
+        for (int i = 0; i < 10000; ++i) {
+            const uint64_t key = rng();
+            const uint32_t expected = engines[0]->getBucketCRC32c(key, 1);
+            for (auto& engine : engines) {
+                ASSERT_EQ(engine->getBucketCRC32c(key, 1), expected);
+            }
+        }
+        for (auto& engine : engines) {
+            expect_batch_matches_scalar(*engine, 4099);
+        }
+    }
+}
+
+TEST(AnchorFastModEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+        AnchorFastModEngine engine(10 * size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(AnchorFastModEngineTest, RandomRemovalOnlyMovesKeysOfRemovedBucket) {
+    AnchorFastModEngine engine(100000, 50000);
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 50000, { 42u, 7u, 43u, 49999u, 12345u });
+    expect_batch_matches_scalar(engine, 4099);
+}
+
+TEST(AnchorEngineTest, GrowableAnchorKeepsKeysWhenGrowing) {
+    for (const char* init : { "eager", "lazy" }) {
+        // Capacity 4: the additions below grow the arrays several times.
+        AnchorEngine engine(4, 3, { { "growable", "true" }, { "init", init } });
+        for (uint32_t size = 3; size < 200; ++size) {
+            expect_minimal_disruption_on_add(engine, size, 20 * (size + 1));
+        }
+
+        std::mt19937_64 rng(23);
+        std::vector<std::pair<uint64_t, uint64_t>> keys(10000);
+        std::vector<uint32_t> before(keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            keys[i] = { rng(), rng() };
+            before[i] = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+        }
+        engine.removeBucket(42);
+        engine.removeBucket(7);
+        engine.reserve(100000);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const auto after = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+            EXPECT_NE(after, 42u);
+            EXPECT_NE(after, 7u);
+            if (before[i] != 42 && before[i] != 7) {
+                EXPECT_EQ(after, before[i]);
+            }
+        }
+        EXPECT_EQ(engine.addBucket(), 7u);
+        EXPECT_EQ(engine.addBucket(), 42u);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(engine.getBucketCRC32c(keys[i].first, keys[i].second), before[i]);
+        }
+        EXPECT_EQ(engine.addBucket(), 200u);
+        expect_batch_matches_scalar(engine, 4099);
+    }
+}
+
+TEST(AnchorEngineTest, TranslationCacheDoesNotChangeTheMapping) {
+    AnchorEngine plain(20000, 10000);
+    AnchorEngine cached(20000, 10000, { { "translation-cache", "true" } });
+    std::mt19937_64 rng(31);
+    std::vector<uint64_t> keys(20000);
+    for (auto& key : keys) {
+        key = rng();
+    }
+
+    // The shortcuts filled by a round of lookups must go stale at each update.
+    for (int round = 0; round < 40; ++round) {
+        if (round % 4 == 3) {
+            EXPECT_EQ(cached.addBucket(), plain.addBucket());
+        }
+        else {
+            for (int i = 0; i < 200; ++i) {
+                const auto bucket = plain.getBucketCRC32c(rng(), 0);
+                plain.removeBucket(bucket);
+                cached.removeBucket(bucket);
+            }
+        }
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const auto key : keys) {
+                ASSERT_EQ(cached.getBucketCRC32c(key, 5), plain.getBucketCRC32c(key, 5));
+            }
+        }
+    }
+}
+
+TEST(JumpBackEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 3u, 64u, 1000u }) {
+        JumpBackEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(BinomialEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 3u, 64u, 96u, 1000u }) {
+        BinomialEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(MaglevEngineTest, TableSizeFromPermutations) {
+    MaglevEngine default_engine(100, 10);
+    EXPECT_EQ(default_engine.tableSize(), 1283u); // smallest prime > 10 * 128
+    MaglevEngine engine(100, 10, { { "permutations", "200" } });
+    EXPECT_EQ(engine.tableSize(), 2003u);
+}
+
+TEST(MaglevEngineTest, TableGrowsWithTheWorkingSet) {
+    MaglevEngine engine(2, 2);
+    for (int i = 0; i < 400; ++i) {
+        engine.addBucket();
+    }
+    EXPECT_GE(engine.tableSize(), 402u * 128 / 2);
+
+    std::mt19937_64 rng(11);
+    std::vector<uint32_t> keys_per_bucket(engine.size());
+    for (int i = 0; i < 402 * 100; ++i) {
+        keys_per_bucket[engine.getBucketCRC32c(rng(), rng())]++;
+    }
+    for (const auto count : keys_per_bucket) {
+        EXPECT_GT(count, 0u);
+    }
+}
+
+TEST(MaglevEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+        MaglevEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(RingEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+        RingEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(RingEngineTest, RandomRemovalOnlyMovesKeysOfRemovedBucket) {
+    RingEngine engine(100, 100, { { "virtualNodes", "50" } });
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 100, { 42u, 7u, 43u, 99u });
+}
+
+TEST(MultiProbeEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+        MultiProbeEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(MultiProbeEngineTest, RandomRemovalOnlyMovesKeysOfRemovedBucket) {
+    MultiProbeEngine engine(100, 100, { { "probes", "5" } });
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 100, { 42u, 7u, 43u, 99u });
+}
+
+TEST(RendezvousEngineTest, MinimalDisruptionOnAdd) {
+    for (const char* mode : { "flat", "skeleton" }) {
+        for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+            RendezvousEngine engine(size, size, { { "mode", mode }, { "fanout", "4" } });
+            expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+        }
+    }
+}
+
+TEST(RendezvousEngineTest, RandomRemovalOnlyMovesKeysOfRemovedBucket) {
+    for (const char* mode : { "flat", "skeleton" }) {
+        RendezvousEngine engine(100, 100, { { "mode", mode } });
+        expect_removal_only_moves_keys_of_removed_bucket(engine, 100, { 42u, 7u, 43u, 99u });
+    }
+}
+
+TEST(RendezvousEngineTest, SkeletonUpdatesOnlyMoveKeysOfThatBucket) {
+    // Mostly removals: the tree ends up with many empty subtrees
+    RendezvousEngine engine(1000, 1000, { { "mode", "skeleton" }, { "fanout", "4" } });
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 1000, {}, 1200, 10);
+}
+
+TEST(RendezvousEngineTest, EmptyClusterHasNoBucket) {
+    for (const char* mode : { "flat", "skeleton" }) {
+        RendezvousEngine engine(2, 2, { { "mode", mode } });
+        engine.removeBucket(0);
+        engine.removeBucket(1);
+        EXPECT_EQ(engine.getBucketCRC32c(1, 2), RendezvousEngine::NO_BUCKET);
+        EXPECT_EQ(engine.addBucket(), 1u);
+        EXPECT_EQ(engine.getBucketCRC32c(1, 2), 1u);
+    }
+}
+
+TEST(FlipHashEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 3u, 4u, 7u, 8u, 100u, 1024u }) {
+        FlipHashEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(FlipHashEngineTest, BatchMatchesScalar) {
+    for (uint32_t size : { 1u, 5u, 64u, 1000u, 65537u }) {
+        FlipHashEngine engine(size, size);
+        expect_batch_matches_scalar(engine, 1003);
+    }
+}
+
+TEST(PowerFastEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 3u, 4u, 7u, 8u, 100u, 1024u }) {
+        PowerFastEngine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(PowerFastEngineTest, BatchMatchesScalar) {
+    for (uint32_t size : { 1u, 2u, 3u, 5u, 64u, 1000u, 65537u, 123457u, 3000000000u, 4294967295u }) {
+        PowerFastEngine engine(size, size);
+        expect_batch_matches_scalar(engine, 4099);
+    }
+}
+
+TEST(PowerFastEngineTest, BucketOfMatchesLookup) {
+    std::mt19937_64 rng(23);
+    for (uint32_t size : { 1u, 3u, 1000u, 10000000u, 4294967295u }) {
+        PowerFastEngine engine(size, size);
+        for (int i = 0; i < 1000; ++i) {
+            const uint64_t key = rng();
+            const uint64_t seed = rng();
+            EXPECT_EQ(PowerFastEngine::bucketOf(crc32c_sse42_u64(key, seed), size),
+                engine.getBucketCRC32c(key, seed));
+        }
+    }
+}
+
+TEST(Jump64EngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+        Jump64Engine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(Power64EngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 3u, 4u, 7u, 8u, 100u, 1024u }) {
+        Power64Engine engine(size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+// Hashes differing only in their 32 highest bits must not share their bucket.
+TEST(Hash64Test, HighHashBitsChangeTheBucket) {
+    constexpr uint32_t size = 10000000;
+    std::mt19937_64 rng(29);
+    int same_jump = 0;
+    int same_power = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const uint64_t low = rng() & 0xFFFFFFFF;
+        const uint64_t high = low | (rng() << 32);
+        same_jump += JumpEngine::bucketOf(low, size) == JumpEngine::bucketOf(high, size);
+        same_power += PowerFastEngine::bucketOf(low, size) == PowerFastEngine::bucketOf(high, size);
+    }
+    EXPECT_LT(same_jump, 10);
+    EXPECT_LT(same_power, 10);
+}
+
+TEST(DxFastEngineTest, MinimalDisruptionOnAdd) {
+    for (uint32_t size : { 1u, 2u, 10u, 100u }) {
+        DxFastEngine engine(10 * size, size);
+        expect_minimal_disruption_on_add(engine, size, 100 * (size + 1));
+    }
+}
+
+TEST(DxFastEngineTest, RandomRemovalOnlyMovesKeysOfRemovedBucket) {
+    DxFastEngine engine(100000, 50000);
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 50000, { 42u, 7u, 43u, 49999u, 12345u });
+}
+
+TEST(DxFastEngineTest, BatchMatchesScalarAfterRandomRemovals) {
+    for (uint32_t capacity : { 10u, 1000u, 100000u }) {
+        DxFastEngine engine(capacity, capacity / 2);
+        std::vector<uint32_t> working(capacity / 2);
+        std::iota(working.begin(), working.end(), 0);
+        std::shuffle(working.begin(), working.end(), std::mt19937(capacity));
+        for (uint32_t i = 0; i < capacity / 5 * 2; ++i) {
+            engine.removeBucket(working[i]);
+        }
+        expect_batch_matches_scalar(engine, 4099);
+        engine.addBucket();
+        expect_batch_matches_scalar(engine, 4099);
+    }
+}
+
+TEST(DxEngineTest, BoundedProbingRemovalsAndRestoresOnlyMoveKeysOfThatBucket) {
+    // Capacity factor 10 and 4 probes: most keys end up in the fallback
+    DxEngine engine(10000, 1000, { { "max-probes", "4" } });
+    ASSERT_EQ(engine.maxProbes(), 4u);
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 1000, {}, 60, 33);
+}
+
+TEST(DxEngineTest, DoublingMovesNoKey) {
+    DxEngine engine(1, 10, { { "growable", "true" } });
+    ASSERT_EQ(engine.capacity(), 10u);
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 10, {}, 600, 70);
+    EXPECT_GE(engine.capacity(), 160u);
+    EXPECT_LT(engine.capacity(), 2 * 600u);
+}
+
+TEST(DxEngineTest, BoundedProbingSurvivesDoubling) {
+    DxEngine engine(1, 10, { { "growable", "true" }, { "max-probes", "2" } });
+    expect_removal_only_moves_keys_of_removed_bucket(engine, 10, {}, 600, 70);
+    EXPECT_GE(engine.capacity(), 160u);
+}
+
+template<typename Engine>
+class MementoBaseHashTest : public ::testing::Test {};
+
+using MementoBaseHashes = ::testing::Types<
+    MementoEngine<std::unordered_map, JumpEngine>,
+    MementoEngine<std::unordered_map, PowerEngine>,
+    MementoEngine<std::unordered_map, BinomialEngine>,
+    MementoEngine<std::unordered_map, FlipHashEngine>>;
+TYPED_TEST_SUITE(MementoBaseHashTest, MementoBaseHashes);
+
+TYPED_TEST(MementoBaseHashTest, RandomRemovalsAndRestoresOnlyMoveKeysOfThatBucket) {
+    TypeParam engine(1000, 1000);
+    std::mt19937_64 rng(19);
+    std::vector<std::pair<uint64_t, uint64_t>> keys(20000);
+    std::vector<uint32_t> before(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = { rng(), rng() };
+        before[i] = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+    }
+
+    auto check = [&](uint32_t changed, bool removed) {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const auto after = engine.getBucketCRC32c(keys[i].first, keys[i].second);
+            if (removed) {
+                ASSERT_NE(after, changed);
+                if (before[i] != changed) {
+                    ASSERT_EQ(after, before[i]);
+                }
+            }
+            else if (after != before[i]) {
+                ASSERT_EQ(after, changed);
+            }
+            before[i] = after;
+        }
+    };
+
+    for (int step = 0; step < 50; ++step) {
+        const uint32_t bucket = before[rng() % before.size()];
+        check(engine.removeBucket(bucket), true);
+    }
+    for (int step = 0; step < 50; ++step) {
+        check(engine.addBucket(), false);
+    }
+    EXPECT_EQ(engine.size(), 1000u);
+}
+
+template<typename Engine>
+class MementoTableTest : public ::testing::Test {};
+
+using MementoTables = ::testing::Types<
+    MementoEngine<MashTable>,
+    MementoEngine<IncrementalMashTable>,
+    MementoEngine<ArenaMashTable>,
+    MementoEngine<DenseTable>,
+    MementoEngine<FlatTable>>;
+TYPED_TEST_SUITE(MementoTableTest, MementoTables);
+
+TYPED_TEST(MementoTableTest, MatchesHashMapBackendThroughRemovalsAndRestores) {
+    MementoEngine<std::unordered_map> reference(1000, 1000);
+    TypeParam dense(1000, 1000);
+    std::mt19937_64 rng(29);
+    std::vector<uint64_t> keys(10000);
+    for (auto& key : keys) {
+        key = rng();
+    }
+
+    auto check = [&] {
+        ASSERT_EQ(dense.size(), reference.size());
+        for (const auto key : keys) {
+            ASSERT_EQ(dense.getBucketCRC32c(key, 3), reference.getBucketCRC32c(key, 3));
+        }
+    };
+
+    // Removing the last bucket shrinks the b-array, restoring it grows it back.
+    for (int round = 0; round < 5; ++round) {
+        for (int step = 0; step < 300; ++step) {
+            const uint32_t last = reference.bArraySize() - 1;
+            const uint32_t bucket = step % 10 == 0 && reference.size() == reference.bArraySize()
+                ? last
+                : reference.getBucketCRC32c(rng(), 0);
+            EXPECT_EQ(dense.removeBucket(bucket), reference.removeBucket(bucket));
+        }
+        check();
+        for (int step = 0; step < 250; ++step) {
+            EXPECT_EQ(dense.addBucket(), reference.addBucket());
+        }
+        check();
+    }
+    // Past the initial b-array, the tables grow with the removed buckets.
+    for (int step = 0; step < 2000; ++step) {
+        EXPECT_EQ(dense.addBucket(), reference.addBucket());
+    }
+    for (int step = 0; step < 1000; ++step) {
+        const uint32_t bucket = reference.getBucketCRC32c(rng(), 0);
+        EXPECT_EQ(dense.removeBucket(bucket), reference.removeBucket(bucket));
+    }
+    check();
+}
+
+TEST(MementoEngineTest, FrozenEngineMatchesEngineAtEveryRemovalRate) {
+    std::mt19937_64 rng(31);
+    std::vector<uint64_t> keys(10000);
+    for (auto& key : keys) {
+        key = rng();
+    }
+
+    // With all the buckets but one removed, the tail of the b-array goes too.
+    for (double rate : { 0.0, 0.1, 0.5, 0.9, 1.0 }) {
+        MementoEngine<std::unordered_map> engine(1000, 1000);
+        std::vector<uint32_t> buckets(1000);
+        std::iota(buckets.begin(), buckets.end(), 0);
+        std::shuffle(buckets.begin(), buckets.end(), rng);
+        for (uint32_t i = 0; i < rate * 999; ++i) {
+            engine.removeBucket(buckets[i]);
+        }
+
+        const auto frozen = engine.freeze();
+        ASSERT_EQ(frozen.size(), engine.size()) << "removal rate " << rate;
+        ASSERT_EQ(frozen.bArraySize(), engine.bArraySize()) << "removal rate " << rate;
+        for (const auto key : keys) {
+            ASSERT_EQ(frozen.getBucketCRC32c(key, 5), engine.getBucketCRC32c(key, 5)) << "removal rate " << rate;
+        }
+        const std::string key{ "frozen" };
+        EXPECT_EQ(frozen.getBucket(key), engine.getBucket(key));
+    }
+}
+
+template<typename Table>
+class ReplacementTableTest : public ::testing::Test {};
+
+using ReplacementTables = ::testing::Types<
+    FlatTable<uint32_t, uint64_t>,
+    IncrementalMashTable<uint32_t, uint64_t>,
+    ArenaMashTable<uint32_t, uint64_t>>;
+TYPED_TEST_SUITE(ReplacementTableTest, ReplacementTables);
+
+TYPED_TEST(ReplacementTableTest, MatchesUnorderedMapThroughInsertionsAndErasures) {
+    TypeParam table;
+    std::unordered_map<uint32_t, uint64_t> reference;
+    std::mt19937_64 rng(37);
+
+    // Small key ranges fill groups with tombstones, large ones grow the table
+    // (and the last one shrinks it, step by step for the incremental tables).
+    for (uint32_t range : { 40u, 1000u, 100000u, 1000u }) {
+        for (int step = 0; step < 100000; ++step) {
+            const uint32_t key = rng() % range;
+            if (rng() % 2 && table.find(key) == table.end()) {
+                table.emplace(key, uint64_t{ key * 3u });
+                reference.emplace(key, key * 3u);
+            }
+            else if (!(rng() % 2)) {
+                table.erase(table.find(key));
+                reference.erase(key);
+            }
+        }
+        ASSERT_EQ(table.size(), reference.size());
+        for (uint32_t key = 0; key < range; ++key) {
+            const auto it = table.find(key);
+            ASSERT_EQ(it != table.end(), reference.count(key) == 1);
+            if (reference.count(key)) {
+                auto found = it;
+                EXPECT_EQ(found->second, reference[key]);
+            }
+        }
+    }
+}
@@ -27,11 +27,16 @@
 #include <charconv> // std::from_chars
 #include <chrono>
 #include <stdexcept>
+#include <unordered_map>
+#include <new>
 
 #include <iostream>
 template<typename T>
 using random_distribution_ptr = T(*)();
 
+// Algorithm specific arguments, as found in the yaml file: [argumentName][argumentValue]
+using engine_arguments = std::unordered_map<std::string, std::string>;
+
 uint32_t crc32c_sse42_u64(uint64_t key, uint64_t seed);
 
 std::vector<double> parse_fractions(const std::string& fractions_str);
@@ -49,6 +54,45 @@ Ret str_to(const std::string& to_parse, Ret default_value_if_fail) {
     return ret;
 }
 
+/*
+ * Creates an engine from the (capacity, size) pair that every algorithm accepts.
+ * Engines that can be configured through the yaml file also receive their arguments.
+ */
+template<typename Algorithm>
+Algorithm make_engine(uint32_t capacity, uint32_t size, const engine_arguments& args) {
+    if constexpr (std::is_constructible_v<Algorithm, uint32_t, uint32_t, const engine_arguments&>) {
+        return Algorithm(capacity, size, args);
+    }
+    else {
+        return Algorithm(capacity, size);
+    }
+}
+
+/*
+ * Minimal allocator returning memory aligned to the given boundary (a cache line by default),
+ * so that containers used by lookups do not split their first elements across two lines.
+ */
+template<typename T, std::size_t Alignment = 64>
+struct aligned_allocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+    aligned_allocator() noexcept = default;
+    template<typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ Alignment }));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        ::operator delete(p, n * sizeof(T), std::align_val_t{ Alignment });
+    }
+
+    template<typename U>
+    bool operator==(const aligned_allocator<U, Alignment>&) const noexcept { return true; }
+};
 
 /*
  * this function generates a sequence of random keys, with key = {random(a), random(b)}